@@ -26,246 +26,387 @@
 
 #include <gio/gio.h>
 #include <gst/gst.h>
-#include <gdk-pixbuf/gdk-pixbuf.h>
+#include <cairo.h>
 
 #include "gst-video-thumbnailer.h"
 
-static void
-push_buffer (GstElement *element,
-             GstBuffer  *out_buffer,
-             GstPad     *pad,
-             GstBuffer  *in_buffer)
+/*
+ * A pool of worker threads makes the shots, each with a playbin2 taken from
+ * a set of idle pipelines that are reused from one file to the next. The
+ * frame comes out of an appsink whose caps ask for the pixel layout and
+ * stride of CAIRO_FORMAT_RGB24, so playbin2's colorspace converter is the
+ * only thing touching the pixels, and the cairo surface wraps the buffer
+ * itself. Each file gets THUMBNAIL_DEADLINE to preroll and seek, after
+ * which its pipeline is thrown away rather than reused.
+ */
+
+#define THUMBNAIL_DEADLINE (5 * G_USEC_PER_SEC)
+#define PLAY_FLAG_VIDEO    (1 << 0) /* GstPlayFlags, no audio nor subtitles */
+
+/* how long get_shot () waits for a shot, a worker stuck in GStreamer must
+ * not hang the caller */
+#define SHOT_WAIT_DEADLINE (THUMBNAIL_DEADLINE + G_USEC_PER_SEC)
+
+struct _GstVideoThumbnailer
 {
-    gst_buffer_set_caps (out_buffer, GST_BUFFER_CAPS (in_buffer));
-    GST_BUFFER_SIZE (out_buffer) = GST_BUFFER_SIZE (in_buffer);
-    memcpy (GST_BUFFER_DATA (out_buffer), GST_BUFFER_DATA (in_buffer),
-            GST_BUFFER_SIZE (in_buffer));
-}
+    GThreadPool *pool;
+    GAsyncQueue *idle;    /* ThumbPipelines not in use */
+    GMutex       lock;    /* protects the fields below */
+    GCond        cond;    /* signalled as shots are done */
+    GHashTable  *shots;   /* location -> Shot */
+    guint        made;    /* shots done, and over which time */
+    gint64       first_queued;
+    gint64       last_done;
+};
+
+typedef struct
+{
+    gboolean         done;
+    cairo_surface_t *surface; /* NULL if it failed */
+} Shot;
+
+typedef struct
+{
+    GstElement *playbin;
+    GstElement *sink;     /* appsink, owned by playbin */
+} ThumbPipeline;
 
 static void
-pull_buffer (GstElement *element,
-             GstBuffer  *in_buffer,
-             GstPad     *pad,
-             GstBuffer **out_buffer)
+shot_free (gpointer data)
 {
-    *out_buffer = gst_buffer_ref (in_buffer);
+    Shot *shot = data;
+
+    if (shot->surface)
+        cairo_surface_destroy (shot->surface);
+    g_slice_free (Shot, shot);
 }
 
-GdkPixbuf *
-convert_buffer_to_pixbuf (GstBuffer    *buffer,
-                          GCancellable *cancellable)
+static ThumbPipeline *
+thumb_pipeline_new (void)
 {
-    GstCaps *pb_caps;
-    GstElement *pipeline;
-    GstBuffer *out_buffer = NULL;
-    GstElement *src, *sink, *colorspace, *scale, *filter;
-    GstBus *bus;
-    GstMessage *msg;
-    GstStateChangeReturn state G_GNUC_UNUSED;
-    gboolean ret;
-    int dw, dh, i;
-    GstStructure *s;
+    ThumbPipeline *pipeline;
+    GstElement *playbin, *sink;
+    GstCaps *caps;
+
+    playbin = gst_element_factory_make ("playbin2", NULL);
+    sink = gst_element_factory_make ("appsink", NULL);
+    if (playbin == NULL || sink == NULL) {
+        g_warning ("Failed to create playbin2 or appsink");
+        if (playbin)
+            gst_object_unref (playbin);
+        if (sink)
+            gst_object_unref (sink);
+        return NULL;
+    }
 
-    s = gst_caps_get_structure (GST_BUFFER_CAPS (buffer), 0);
-    gst_structure_get_int (s, "width", &dw);
-    gst_structure_get_int (s, "height", &dh);
-
-    pb_caps = gst_caps_new_simple ("video/x-raw-rgb",
-                                   "bpp", G_TYPE_INT, 24,
-                                   "depth", G_TYPE_INT, 24,
-                                   "width", G_TYPE_INT, dw,
-                                   "height", G_TYPE_INT, dh,
-                                   "pixel-aspect-ratio", GST_TYPE_FRACTION, 1, 1,
-                                   NULL);
-
-    pipeline = gst_pipeline_new ("pipeline");
-
-    src = gst_element_factory_make ("fakesrc", "src");
-    colorspace = gst_element_factory_make ("ffmpegcolorspace", "colorspace");
-    scale = gst_element_factory_make ("videoscale", "scale");
-    filter = gst_element_factory_make ("capsfilter", "filter");
-    sink = gst_element_factory_make ("fakesink", "sink");
-
-    gst_bin_add_many (GST_BIN (pipeline), src, colorspace, scale,
-                      filter, sink, NULL);
-
-    g_object_set (filter,
-                  "caps", pb_caps,
-                  NULL);
-    g_object_set (src,
-                  "num-buffers", 1,
-                  "sizetype", 2,
-                  "sizemax", GST_BUFFER_SIZE (buffer),
-                  "signal-handoffs", TRUE,
+    /* CAIRO_FORMAT_RGB24: native endian 32 bit words holding xRGB, the
+     * masks being those of the words read as big endian */
+    caps = gst_caps_new_simple ("video/x-raw-rgb",
+                                "bpp", G_TYPE_INT, 32,
+                                "depth", G_TYPE_INT, 24,
+                                "endianness", G_TYPE_INT, G_BIG_ENDIAN,
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+                                "red_mask", G_TYPE_INT, 0x0000ff00,
+                                "green_mask", G_TYPE_INT, 0x00ff0000,
+                                "blue_mask", G_TYPE_INT, 0xff000000,
+#else
+                                "red_mask", G_TYPE_INT, 0x00ff0000,
+                                "green_mask", G_TYPE_INT, 0x0000ff00,
+                                "blue_mask", G_TYPE_INT, 0x000000ff,
+#endif
+                                "pixel-aspect-ratio", GST_TYPE_FRACTION, 1, 1,
+                                NULL);
+    g_object_set (sink,
+                  "caps", caps,
+                  "sync", FALSE,
+                  "max-buffers", 1,
+                  "drop", TRUE,
                   NULL);
-    g_signal_connect (src, "handoff",
-                      G_CALLBACK (push_buffer), buffer);
+    gst_caps_unref (caps);
 
-    g_object_set (sink,
-                  "signal-handoffs", TRUE,
-                  "preroll-queue-len", 1,
+    g_object_set (playbin,
+                  "video-sink", sink,
+                  "flags", PLAY_FLAG_VIDEO,
                   NULL);
-    g_signal_connect (sink, "handoff",
-                      G_CALLBACK (pull_buffer), &out_buffer);
 
-    ret = gst_element_link (src, colorspace);
-    if (ret == FALSE) {
-        g_warning ("Failed to link src->colorspace");
-        return NULL;
-    }
+    pipeline = g_slice_new (ThumbPipeline);
+    pipeline->playbin = playbin;
+    pipeline->sink = sink;
 
-    ret = gst_element_link (colorspace, scale);
-    if (ret == FALSE) {
-        g_warning ("Failed to link colorspace->scale");
-        return NULL;
-    }
+    return pipeline;
+}
+
+static void
+thumb_pipeline_free (ThumbPipeline *pipeline)
+{
+    gst_element_set_state (pipeline->playbin, GST_STATE_NULL);
+    gst_object_unref (pipeline->playbin);
+    g_slice_free (ThumbPipeline, pipeline);
+}
+
+/* waits for a state change until @deadline, on the monotonic clock */
+static GstStateChangeReturn
+wait_state (GstElement *element,
+            gint64      deadline)
+{
+    gint64 remaining = deadline - g_get_monotonic_time ();
+
+    if (remaining <= 0)
+        return GST_STATE_CHANGE_ASYNC;
+    return gst_element_get_state (element, NULL, NULL,
+                                  remaining * GST_USECOND);
+}
+
+/* Takes the reference to @buffer, which the surface keeps until it is
+ * destroyed. 32 bit pixels need no padding, so the stride of the buffer is
+ * what cairo wants for this width.
+ */
+static cairo_surface_t *
+buffer_to_surface (GstBuffer *buffer)
+{
+    static const cairo_user_data_key_t key;
+    cairo_surface_t *surface;
+    GstStructure *s;
+    int width = 0, height = 0, stride;
 
-    ret = gst_element_link (scale, filter);
-    if (ret == FALSE) {
-        g_warning ("Failed to link scale->filter");
+    s = gst_caps_get_structure (GST_BUFFER_CAPS (buffer), 0);
+    gst_structure_get_int (s, "width", &width);
+    gst_structure_get_int (s, "height", &height);
+    stride = cairo_format_stride_for_width (CAIRO_FORMAT_RGB24, width);
+    if (width <= 0 || height <= 0 || stride != width * 4 ||
+        GST_BUFFER_SIZE (buffer) < (guint) (stride * height)) {
+        gst_buffer_unref (buffer);
         return NULL;
     }
 
-    ret = gst_element_link (filter, sink);
-    if (ret == FALSE) {
-        g_warning ("Failed to link filter->sink");
+    surface = cairo_image_surface_create_for_data (GST_BUFFER_DATA (buffer),
+                                                   CAIRO_FORMAT_RGB24,
+                                                   width, height, stride);
+    if (cairo_surface_status (surface) != CAIRO_STATUS_SUCCESS) {
+        cairo_surface_destroy (surface);
+        gst_buffer_unref (buffer);
         return NULL;
     }
+    cairo_surface_set_user_data (surface, &key, buffer,
+                                 (cairo_destroy_func_t) gst_buffer_unref);
 
-    bus = gst_element_get_bus (GST_ELEMENT (pipeline));
-    state = gst_element_set_state (GST_ELEMENT (pipeline), GST_STATE_PLAYING);
+    return surface;
+}
 
-    i = 0;
-    msg = NULL;
-    while (msg == NULL && i < 5) {
-        msg = gst_bus_timed_pop_filtered (bus, GST_SECOND,
-                                          GST_MESSAGE_ERROR | GST_MESSAGE_EOS);
-        i++;
+/* Makes a shot of @location with @pipeline. *reusable is set to FALSE when
+ * the pipeline did not make it in time and is better thrown away.
+ */
+static cairo_surface_t *
+thumb_pipeline_get_shot (ThumbPipeline *pipeline,
+                         const gchar   *location,
+                         gint64         deadline,
+                         gboolean      *reusable)
+{
+    GstStateChangeReturn state;
+    GstFormat format = GST_FORMAT_TIME;
+    GstBuffer *frame = NULL;
+    GstMessage *msg;
+    GstBus *bus;
+    cairo_surface_t *shot = NULL;
+    gint64 duration, seekpos = 0;
+    gchar *uri;
+
+    uri = g_filename_to_uri (location, NULL, NULL);
+    if (uri == NULL)
+        uri = g_strconcat ("file://", location, NULL);
+
+    g_object_set (pipeline->playbin, "uri", uri, NULL);
+    state = gst_element_set_state (pipeline->playbin, GST_STATE_PAUSED);
+    if (state == GST_STATE_CHANGE_ASYNC)
+        state = wait_state (pipeline->playbin, deadline);
+    if (state == GST_STATE_CHANGE_FAILURE || state == GST_STATE_CHANGE_ASYNC)
+        goto finish;
+
+    if (gst_element_query_duration (pipeline->playbin, &format, &duration)) {
+        if (duration / (3 * GST_SECOND) > 90) {
+            seekpos = g_random_int_range (0, duration / (3 * GST_SECOND)) *
+                      GST_SECOND;
+        } else if (duration >= GST_SECOND) {
+            seekpos = g_random_int_range (0, duration / GST_SECOND) *
+                      GST_SECOND;
+        }
     }
 
-    /* FIXME: Notify about error? */
-    gst_message_unref (msg);
+    /* otherwise the prerolled frame will do */
+    if (seekpos > 0 &&
+        gst_element_seek_simple (pipeline->playbin, GST_FORMAT_TIME,
+                                 GST_SEEK_FLAG_FLUSH |
+                                 GST_SEEK_FLAG_ACCURATE, seekpos)) {
+        state = wait_state (pipeline->playbin, deadline);
+        if (state == GST_STATE_CHANGE_FAILURE ||
+            state == GST_STATE_CHANGE_ASYNC)
+            goto finish;
+    }
 
-    gst_caps_unref (pb_caps);
+    g_signal_emit_by_name (pipeline->sink, "pull-preroll", &frame);
+    if (frame == NULL) {
+        g_warning ("No frame for %s", uri);
+        goto finish;
+    }
 
-    if (out_buffer) {
-        GdkPixbuf *pixbuf;
-        char *data;
+    shot = buffer_to_surface (frame);
 
-        data = g_memdup (GST_BUFFER_DATA (out_buffer),
-                         GST_BUFFER_SIZE (out_buffer));
-        pixbuf = gdk_pixbuf_new_from_data ((guchar *) data,
-                                           GDK_COLORSPACE_RGB, FALSE,
-                                           8, dw, dh, GST_ROUND_UP_4 (dw * 3),
-                                           (GdkPixbufDestroyNotify) g_free,
-                                           NULL);
+ finish:
 
-        gst_buffer_unref (buffer);
-        return pixbuf;
+    if (state == GST_STATE_CHANGE_ASYNC) {
+        g_warning ("Timed out making a thumbnail of %s", uri);
+        *reusable = FALSE;
     }
 
-    /* FIXME: Check what buffers need freed */
-    return NULL;
-}
+    /* nobody else reads the bus */
+    bus = gst_element_get_bus (pipeline->playbin);
+    while ((msg = gst_bus_pop (bus))) {
+        if (GST_MESSAGE_TYPE (msg) == GST_MESSAGE_ERROR) {
+            GError *error = NULL;
 
-GdkPixbuf *
-gst_video_thumbnailer_get_shot (const gchar  *location,
-          GCancellable *cancellable)
-{
-    GstElement *playbin, *audio_sink, *video_sink;
-    GstStateChangeReturn state;
-    GdkPixbuf *shot = NULL;
-    int count = 0;
-    gchar *uri = g_strconcat ("file://", location, NULL);
-    GMainContext *context = g_main_context_new ();
+            gst_message_parse_error (msg, &error, NULL);
+            g_warning ("Could not play %s: %s", uri, error->message);
+            g_error_free (error);
+        }
+        gst_message_unref (msg);
+    }
+    gst_object_unref (bus);
 
-    g_main_context_push_thread_default  (context);
+    if (*reusable)
+        gst_element_set_state (pipeline->playbin, GST_STATE_READY);
+    g_free (uri);
 
-    playbin = gst_element_factory_make ("playbin", "playbin");
-    audio_sink = gst_element_factory_make ("fakesink", "audiosink");
-    video_sink = gst_element_factory_make ("fakesink", "videosink");
+    return shot;
+}
 
-    g_object_set (playbin,
-                  "uri", uri,
-                  "audio-sink", audio_sink,
-                  "video-sink", video_sink,
-                  NULL);
-    g_object_set (video_sink,
-                  "sync", TRUE,
-                  NULL);
-    state = gst_element_set_state (playbin, GST_STATE_PAUSED);
-    while (state == GST_STATE_CHANGE_ASYNC
-           && count < 5
-           && !g_cancellable_is_cancelled (cancellable)) {
-        state = gst_element_get_state (playbin, NULL, 0, 1 * GST_SECOND);
-        count++;
-
-        /* Spin mainloop so we can pick up the cancels */
-        while (g_main_context_pending (context)) {
-            g_main_context_iteration (context, FALSE);
-        }
+static void
+thumbnailer_run (gpointer data,
+                 gpointer user_data)
+{
+    const gchar *location = data;
+    GstVideoThumbnailer *thumbnailer = user_data;
+    ThumbPipeline *pipeline;
+    cairo_surface_t *surface = NULL;
+    gboolean reusable = TRUE;
+    gint64 start = g_get_monotonic_time ();
+    Shot *shot;
+
+    pipeline = g_async_queue_try_pop (thumbnailer->idle);
+    if (pipeline == NULL)
+        pipeline = thumb_pipeline_new ();
+
+    if (pipeline) {
+        surface = thumb_pipeline_get_shot (pipeline, location,
+                                           start + THUMBNAIL_DEADLINE,
+                                           &reusable);
+        if (reusable)
+            g_async_queue_push (thumbnailer->idle, pipeline);
+        else
+            thumb_pipeline_free (pipeline);
     }
 
+    g_debug ("thumbnail of %s made in %.2fms", location,
+             (g_get_monotonic_time () - start) / 1000.0);
+
+    g_mutex_lock (&thumbnailer->lock);
+    shot = g_hash_table_lookup (thumbnailer->shots, location);
+    shot->surface = surface;
+    shot->done = TRUE;
+    thumbnailer->made++;
+    thumbnailer->last_done = g_get_monotonic_time ();
+    g_cond_broadcast (&thumbnailer->cond);
+    g_mutex_unlock (&thumbnailer->lock);
+}
 
-    if (g_cancellable_is_cancelled (cancellable)) {
-        g_print ("Video %s was cancelled\n", uri);
-        state = GST_STATE_CHANGE_FAILURE;
-    }
+/* makes shots of up to @max_threads videos at the same time */
+GstVideoThumbnailer *
+gst_video_thumbnailer_new (guint max_threads)
+{
+    GstVideoThumbnailer *thumbnailer = g_slice_new0 (GstVideoThumbnailer);
 
-    if (state != GST_STATE_CHANGE_FAILURE &&
-        state != GST_STATE_CHANGE_ASYNC) {
-        GstFormat format = GST_FORMAT_TIME;
-        gint64 duration;
-
-        if (gst_element_query_duration (playbin, &format, &duration)) {
-            gint64 seekpos;
-            GstBuffer *frame;
-
-            if (duration > 0) {
-                if (duration / (3 * GST_SECOND) > 90) {
-                    seekpos = (rand () % (duration / (3 * GST_SECOND))) * GST_SECOND;
-                } else {
-                    seekpos = (rand () % (duration / (GST_SECOND))) * GST_SECOND;
-                }
-            } else {
-                seekpos = 5 * GST_SECOND;
-            }
-
-            gst_element_seek_simple (playbin, GST_FORMAT_TIME,
-                                     GST_SEEK_FLAG_FLUSH |
-                                     GST_SEEK_FLAG_ACCURATE, seekpos);
-
-            /* Wait for seek to complete */
-            count = 0;
-            state = gst_element_get_state (playbin, NULL, 0,
-                                           0.2 * GST_SECOND);
-            while (state == GST_STATE_CHANGE_ASYNC && count < 3) {
-                state = gst_element_get_state (playbin, NULL, 0, 1 * GST_SECOND);
-                count++;
-            }
-
-            g_object_get (playbin,
-                          "frame", &frame,
-                          NULL);
-            if (frame == NULL) {
-                g_warning ("No frame for %s", uri);
-                shot = NULL;
-                goto finish;
-            }
-
-            shot = convert_buffer_to_pixbuf (frame, cancellable);
-        }
-    }
+    g_mutex_init (&thumbnailer->lock);
+    g_cond_init (&thumbnailer->cond);
+    thumbnailer->shots = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                g_free, shot_free);
+    thumbnailer->idle = g_async_queue_new ();
+    thumbnailer->pool = g_thread_pool_new (thumbnailer_run, thumbnailer,
+                                           max_threads, FALSE, NULL);
 
-    gst_element_set_state (playbin, GST_STATE_NULL);
-    g_object_unref (playbin);
-    g_free (uri);
+    return thumbnailer;
+}
 
- finish:
+void
+gst_video_thumbnailer_free (GstVideoThumbnailer *thumbnailer)
+{
+    ThumbPipeline *pipeline;
+
+    g_thread_pool_free (thumbnailer->pool, TRUE, TRUE);
+
+    if (thumbnailer->made)
+        g_debug ("%u video thumbnails in %.2fs, %.1f per second",
+                 thumbnailer->made,
+                 (thumbnailer->last_done - thumbnailer->first_queued) /
+                 (gdouble) G_USEC_PER_SEC,
+                 thumbnailer->made * (gdouble) G_USEC_PER_SEC /
+                 MAX (thumbnailer->last_done - thumbnailer->first_queued, 1));
+
+    while ((pipeline = g_async_queue_try_pop (thumbnailer->idle)))
+        thumb_pipeline_free (pipeline);
+    g_async_queue_unref (thumbnailer->idle);
+
+    g_hash_table_unref (thumbnailer->shots);
+    g_cond_clear (&thumbnailer->cond);
+    g_mutex_clear (&thumbnailer->lock);
+    g_slice_free (GstVideoThumbnailer, thumbnailer);
+}
 
-    g_main_context_pop_thread_default (context);
-    g_main_context_unref (context);
+/* starts making the shot of @location, if that was not asked before */
+void
+gst_video_thumbnailer_queue (GstVideoThumbnailer *thumbnailer,
+                             const gchar         *location)
+{
+    gchar *key;
+
+    g_mutex_lock (&thumbnailer->lock);
+    if (g_hash_table_lookup (thumbnailer->shots, location) == NULL) {
+        if (g_hash_table_size (thumbnailer->shots) == 0)
+            thumbnailer->first_queued = g_get_monotonic_time ();
+        key = g_strdup (location);
+        g_hash_table_insert (thumbnailer->shots, key,
+                             g_slice_new0 (Shot));
+        g_thread_pool_push (thumbnailer->pool, key, NULL);
+    }
+    g_mutex_unlock (&thumbnailer->lock);
+}
 
-    return shot;
+/* Waits for the shot of @location, queueing it first if needed. Returns a
+ * new reference to a CAIRO_FORMAT_RGB24 surface, or NULL when no frame
+ * could be had in time or the shot did not finish within
+ * SHOT_WAIT_DEADLINE.
+ */
+cairo_surface_t *
+gst_video_thumbnailer_get_shot (GstVideoThumbnailer *thumbnailer,
+                                const gchar         *location)
+{
+    cairo_surface_t *surface = NULL;
+    gint64 deadline;
+    Shot *shot;
+
+    gst_video_thumbnailer_queue (thumbnailer, location);
+
+    deadline = g_get_monotonic_time () + SHOT_WAIT_DEADLINE;
+    g_mutex_lock (&thumbnailer->lock);
+    shot = g_hash_table_lookup (thumbnailer->shots, location);
+    while (!shot->done)
+        if (!g_cond_wait_until (&thumbnailer->cond, &thumbnailer->lock,
+                                deadline))
+            break;
+    if (shot->done && shot->surface)
+        surface = cairo_surface_reference (shot->surface);
+    else if (!shot->done)
+        g_warning ("Timed out waiting for a thumbnail of %s", location);
+    g_mutex_unlock (&thumbnailer->lock);
+
+    return surface;
 }
 #endif /* USE_CLUTTER_GST */
@@ -23,5 +23,14 @@
 #include "config.h"
 #endif
 
-GdkPixbuf * gst_video_thumbnailer_get_shot (const gchar *location, GCancellable *cancellable);
+#include <cairo.h>
+
+typedef struct _GstVideoThumbnailer GstVideoThumbnailer;
+
+GstVideoThumbnailer * gst_video_thumbnailer_new      (guint                max_threads);
+void                  gst_video_thumbnailer_free     (GstVideoThumbnailer *thumbnailer);
+void                  gst_video_thumbnailer_queue    (GstVideoThumbnailer *thumbnailer,
+                                                      const gchar         *location);
+cairo_surface_t *     gst_video_thumbnailer_get_shot (GstVideoThumbnailer *thumbnailer,
+                                                      const gchar         *location);
 #endif
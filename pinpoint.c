@@ -29,6 +29,9 @@
 #include <stdlib.h>
 #include <ctype.h>
 
+#include <glib/gstdio.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
+
 #include "pinpoint.h"
 
 #ifdef USE_CLUTTER_GST
@@ -37,8 +40,8 @@
 
 /* Probably time to create a PinPointPresentation type */
 
-GList *pp_slides      = NULL; /* list of slide text */
-GList *pp_slidep      = NULL; /* current slide */
+GPtrArray *pp_slides  = NULL; /* array of slides */
+gint   pp_slideno     = -1;   /* index of the current slide */
 GFile *pp_basedir     = NULL; /* basedir to resolve relative paths against */
 
 typedef struct
@@ -64,6 +67,7 @@ static PinPointPoint pin_default_point = {
   .bg = NULL,
   .bg_type = PP_BG_NONE,
   .bg_scale = PP_BG_FIT,
+  .asset = NULL,
 
   .text = NULL,
   .position = CLUTTER_GRAVITY_CENTER,
@@ -84,9 +88,16 @@ static PinPointPoint pin_default_point = {
 
   .command = NULL,
 
+  .video_start = 0.0,
+
   .camera_framerate = 0,                    /* auto */
   .camera_resolution = {0, 0},              /* auto */
 
+  .source = NULL,
+  .source_len = 0,
+
+  .ready = FALSE,
+
   .data = NULL,
 };
 
@@ -94,12 +105,39 @@ static PinPointPoint default_point;
 
 PinPointPoint *point_defaults = &default_point;
 
+/* Slide texts, speaker notes and setting values of the current parse live
+ * here, and are released all at once when the presentation is parsed again.
+ */
+static GStringChunk *pp_strings = NULL;
+
+/* Renderer data is only kept for the slides around the current one, see
+ * pp_slides_window_update ().
+ */
+static PinPointRenderer *pp_renderer     = NULL;
+static guint             pp_window_tag   = 0;
+static gint64            pp_window_start = 0;
+static GList            *pp_animating    = NULL; /* points, not to unmake */
+static guint             pp_made         = 0;    /* slides that are ready */
+
+/* where the parsed presentation is cached, see pp_cache_load () */
+static char *pp_cache_file = NULL;
+static char *pp_cache_stored = NULL; /* checksum in it, as last loaded or
+                                        saved */
+static gboolean pp_cache_probed = FALSE; /* asset sizes were probed since */
+
 char     *pp_output_filename = NULL;
 gboolean  pp_fullscreen      = FALSE;
 gboolean  pp_maximized       = FALSE;
 gboolean  pp_speakermode     = FALSE;
 gboolean  pp_rehearse        = FALSE;
+gboolean  pp_stats           = FALSE;
 char     *pp_camera_device   = NULL;
+gboolean  pp_stream          = FALSE;
+gint      pp_stream_keep     = 0;
+gint      pp_window_before   = 1;
+gint      pp_window_after    = 3;
+gint      pp_max_made        = 32;
+gint      pp_texture_budget  = 256;
 
 static GOptionEntry entries[] =
 {
@@ -114,11 +152,27 @@ static GOptionEntry entries[] =
     "Show speakermode window", NULL},
     { "rehearse", 'r', 0, G_OPTION_ARG_NONE, &pp_rehearse,
     "Rehearse timings", NULL},
+    { "stats", 0, 0, G_OPTION_ARG_NONE, &pp_stats,
+      "Show frame timing statistics (F3 toggles)", NULL },
     { "output", 'o', 0, G_OPTION_ARG_STRING, &pp_output_filename,
       "Output presentation to FILE\n"
 "                                         (formats supported: pdf)", "FILE" },
     { "camera", 'c', 0, G_OPTION_ARG_STRING, &pp_camera_device,
       "Device to use for [camera] background", "DEVICE" },
+    { "stream", 0, 0, G_OPTION_ARG_NONE, &pp_stream,
+      "Read slides from the presentation, or stdin,\n"
+"                                         as they are written to it", NULL },
+    { "stream-keep", 0, 0, G_OPTION_ARG_INT, &pp_stream_keep,
+      "Drop the oldest slides beyond N when streaming", "N" },
+    { "window-before", 0, 0, G_OPTION_ARG_INT, &pp_window_before,
+      "Prepare N slides before the current one (1)", "N" },
+    { "window-after", 0, 0, G_OPTION_ARG_INT, &pp_window_after,
+      "Prepare N slides after the current one (3)", "N" },
+    { "max-slides", 0, 0, G_OPTION_ARG_INT, &pp_max_made,
+      "Keep at most N slides prepared, 0 for all (32)", "N" },
+    { "texture-budget", 0, 0, G_OPTION_ARG_INT, &pp_texture_budget,
+      "Keep at most MB of background textures\n"
+"                                         loaded, 0 for no limit (256)", "MB" },
     { NULL }
 };
 
@@ -127,15 +181,22 @@ PinPointRenderer *pp_clutter_renderer (void);
 PinPointRenderer *pp_cairo_renderer   (void);
 #endif
 static char * pp_serialize (void);
+static void   pp_cache_save (const char *slide_src);
+static void   pp_cache_init (GFile *file);
+static void   pin_point_make (PinPointRenderer *renderer,
+                              PinPointPoint    *point);
+static void   pin_point_unmake (PinPointRenderer *renderer,
+                                PinPointPoint    *point);
 
 void pp_rehearse_init (void)
 {
-  GList *iter;
-  for (iter = pp_slides; iter; iter=iter->next)
+  guint i;
+  for (i = 0; i < pp_slide_count (); i++)
     {
-      PinPointPoint *point = iter->data;
+      PinPointPoint *point = pp_slide_nth (i);
       point->new_duration = 0.0;
     }
+  pp_timing_rebuild ();
 }
 
 
@@ -159,12 +220,13 @@ static void pp_rehearse_save (void)
 
 void pp_rehearse_done (void)
 {
-  GList *iter;
-  for (iter = pp_slides; iter; iter=iter->next)
+  guint i;
+  for (i = 0; i < pp_slide_count (); i++)
     {
-      PinPointPoint *point = iter->data;
+      PinPointPoint *point = pp_slide_nth (i);
       point->duration = point->new_duration;
     }
+  pp_timing_rebuild ();
   pp_rehearse_save ();
 }
 
@@ -192,7 +254,12 @@ main (int    argc,
 
   pinfile = argv[1];
 
-  if (!pinfile)
+  if (pp_stream)
+    {
+      /* the slides are read by the renderer as they come in */
+      text = g_strdup ("");
+    }
+  else if (!pinfile)
     {
       g_print ("usage: %s [options] <presentation>\n", argv[0]);
       text = g_strdup ("[no-markup][transition=sheet][red]\n"
@@ -223,14 +290,20 @@ main (int    argc,
 #ifdef HAVE_PDF
       renderer = pp_cairo_renderer ();
       /* makes more sense to default to a white "stage" colour in PDFs*/
-      default_point.stage_color = "white";
+      pin_default_point.stage_color = "white";
 #else
       g_warning ("Pinpoint was built without PDF support");
       return EXIT_FAILURE;
 #endif
     }
 
-  if (!pinfile)
+  if (pp_stream && renderer != pp_clutter_renderer ())
+    {
+      g_warning ("Streaming only works when presenting");
+      return EXIT_FAILURE;
+    }
+
+  if (!pinfile || pp_stream)
     pp_rehearse = FALSE;
 
   if (pinfile)
@@ -239,6 +312,8 @@ main (int    argc,
 
       file = g_file_new_for_commandline_arg (pinfile);
       pp_basedir = g_file_get_parent (file);
+      if (!pp_stream)
+        pp_cache_init (file);
       g_object_unref (file);
     }
 
@@ -252,6 +327,9 @@ main (int    argc,
       printf ("Running in rehearsal mode, press ctrl+C to abort without saving timings back to %s\n", pinfile);
     }
   renderer->run (renderer);
+  /* keep the asset sizes probed while presenting for the next start */
+  if (renderer->source)
+    pp_cache_save (renderer->source);
   renderer->finalize (renderer);
   if (renderer->source)
     g_free (renderer->source);
@@ -260,7 +338,15 @@ main (int    argc,
     pp_rehearse_save ();
 #endif
 
-  g_list_free (pp_slides);
+  if (pp_window_tag)
+    g_source_remove (pp_window_tag);
+  g_list_free (pp_animating);
+  if (pp_slides)
+    g_ptr_array_free (pp_slides, TRUE);
+  if (pp_strings)
+    g_string_chunk_free (pp_strings);
+  g_free (pp_cache_file);
+  g_free (pp_cache_stored);
 
   return 0;
 }
@@ -268,6 +354,503 @@ main (int    argc,
 /*********************/
 
 
+/*
+ * Slides
+ */
+
+guint
+pp_slide_count (void)
+{
+  return pp_slides ? pp_slides->len : 0;
+}
+
+PinPointPoint *
+pp_slide_nth (gint n)
+{
+  if (n < 0 || n >= (gint) pp_slide_count ())
+    return NULL;
+  return g_ptr_array_index (pp_slides, n);
+}
+
+/* like pp_slide_nth (), making the slide first if that did not happen yet */
+PinPointPoint *
+pp_slide_ready (gint n)
+{
+  PinPointPoint *point = pp_slide_nth (n);
+
+  if (point && !point->ready)
+    pin_point_make (pp_renderer, point);
+  return point;
+}
+
+PinPointPoint *
+pp_slide_current (void)
+{
+  return pp_slide_ready (pp_slideno);
+}
+
+/* Where point is in the presentation, -1 if it is not in it. The slides the
+ * renderer deals with are near the current one, so that is where the search
+ * starts.
+ */
+gint
+pp_slide_index (PinPointPoint *point)
+{
+  gint current = CLAMP (pp_slideno, 0, (gint) pp_slide_count ());
+  gint d;
+
+  for (d = 0; current - d >= 0 || current + d < (gint) pp_slide_count (); d++)
+    {
+      if (pp_slide_nth (current + d) == point)
+        return current + d;
+      if (d && pp_slide_nth (current - d) == point)
+        return current - d;
+    }
+  return -1;
+}
+
+/* the nearest slide in the window around the current one that is not ready,
+ * -1 if there is none */
+static gint
+pp_window_next (void)
+{
+  gint current = MAX (pp_slideno, 0);
+  gint d;
+
+  for (d = 0; d <= MAX (pp_window_before, pp_window_after); d++)
+    {
+      PinPointPoint *point;
+
+      if (d <= pp_window_after &&
+          (point = pp_slide_nth (current + d)) && !point->ready)
+        return current + d;
+      if (d <= pp_window_before &&
+          (point = pp_slide_nth (current - d)) && !point->ready)
+        return current - d;
+    }
+  return -1;
+}
+
+/* Unmake slides outside of the window, farthest from the current one first,
+ * until at most pp_max_made are left. The slides are visited from both ends
+ * of the presentation inwards, so each is looked at once at most. Camera
+ * slides share one pipeline and are kept, as are the slides that are still
+ * animating.
+ */
+static void
+pp_window_trim (void)
+{
+  gint current = MAX (pp_slideno, 0);
+  gint first   = 0;
+  gint last    = (gint) pp_slide_count () - 1;
+
+  while (pp_max_made > 0 && pp_made > (guint) pp_max_made && first <= last)
+    {
+      gboolean       first_out = first < current - pp_window_before;
+      gboolean       last_out  = last > current + pp_window_after;
+      PinPointPoint *point;
+      gint           i;
+
+      if (!first_out && !last_out)
+        break; /* what is left is in the window */
+      if (first_out && (!last_out || current - first >= last - current))
+        i = first++;
+      else
+        i = last--;
+
+      point = pp_slide_nth (i);
+      if (point->ready && point->bg_type != PP_BG_CAMERA && !point->animating)
+        pin_point_unmake (pp_renderer, point);
+    }
+}
+
+static gboolean
+pp_window_idle (gpointer user_data)
+{
+  gint n = pp_window_next ();
+
+  if (n >= 0)
+    {
+      pp_slide_ready (n);
+      return TRUE;
+    }
+
+  pp_window_trim ();
+
+  g_debug ("slides around %d ready %.2fms later, %u of %u slides made",
+           pp_slideno, (g_get_monotonic_time () - pp_window_start) / 1000.0,
+           pp_made, pp_slide_count ());
+  pp_window_tag = 0;
+  return FALSE;
+}
+
+/* The renderer marks the slides it is animating in or out, from when they
+ * are shown or left until their transition completes. They are not unmade
+ * meanwhile.
+ */
+void
+pp_slide_set_animating (PinPointPoint *point,
+                        gboolean       animating)
+{
+  if (point->animating == animating)
+    return;
+
+  point->animating = animating;
+  if (animating)
+    {
+      pp_animating = g_list_prepend (pp_animating, point);
+    }
+  else
+    {
+      pp_animating = g_list_remove (pp_animating, point);
+
+      /* it may have kept the window from being trimmed */
+      if (pp_max_made > 0 && pp_made > (guint) pp_max_made && !pp_window_tag)
+        pp_window_tag = g_idle_add_full (G_PRIORITY_LOW, pp_window_idle,
+                                         NULL, NULL);
+    }
+}
+
+/* the points marked with pp_slide_set_animating (), owned by us */
+GList *
+pp_slides_animating (void)
+{
+  return pp_animating;
+}
+
+/* To be called when the current slide changes: the slides around it are made
+ * one at a time, below the priority of redraws and input, and the ones
+ * beyond the budget are unmade after that.
+ */
+void
+pp_slides_window_update (void)
+{
+  pp_window_start = g_get_monotonic_time ();
+  if (!pp_window_tag)
+    pp_window_tag = g_idle_add_full (G_PRIORITY_LOW, pp_window_idle,
+                                     NULL, NULL);
+}
+
+/*
+ * Timing
+ *
+ * The speaker screen asks for durations of slide ranges many times a
+ * second. Slides up to the current one count with their rehearsed time (when
+ * there is one), the ones after it with their planned time, so both are kept
+ * as prefix sums: element n is the total of the first n slides.
+ */
+
+static GArray *pp_planned   = NULL;
+static GArray *pp_rehearsed = NULL;
+
+static gdouble
+slide_planned_time (PinPointPoint *point)
+{
+  return point->duration != 0.0 ? point->duration : 2.0;
+}
+
+static gdouble
+slide_rehearsed_time (PinPointPoint *point)
+{
+  return point->new_duration != 0.0 ? point->new_duration
+                                    : slide_planned_time (point);
+}
+
+void
+pp_timing_rebuild (void)
+{
+  gdouble planned = 0.0, rehearsed = 0.0;
+  guint   i;
+
+  if (!pp_planned)
+    {
+      pp_planned = g_array_new (FALSE, FALSE, sizeof (gdouble));
+      pp_rehearsed = g_array_new (FALSE, FALSE, sizeof (gdouble));
+    }
+  g_array_set_size (pp_planned, 0);
+  g_array_set_size (pp_rehearsed, 0);
+
+  for (i = 0; i <= pp_slide_count (); i++)
+    {
+      g_array_append_val (pp_planned, planned);
+      g_array_append_val (pp_rehearsed, rehearsed);
+
+      if (i < pp_slide_count ())
+        {
+          planned += slide_planned_time (pp_slide_nth (i));
+          rehearsed += slide_rehearsed_time (pp_slide_nth (i));
+        }
+    }
+}
+
+/* add the sums of the slides appended since the last rebuild */
+static void
+pp_timing_extend (void)
+{
+  guint i;
+
+  if (!pp_planned || !pp_planned->len ||
+      pp_planned->len > pp_slide_count () + 1)
+    {
+      pp_timing_rebuild ();
+      return;
+    }
+
+  for (i = pp_planned->len - 1; i < pp_slide_count (); i++)
+    {
+      gdouble planned, rehearsed;
+
+      planned = g_array_index (pp_planned, gdouble, i) +
+                slide_planned_time (pp_slide_nth (i));
+      rehearsed = g_array_index (pp_rehearsed, gdouble, i) +
+                  slide_rehearsed_time (pp_slide_nth (i));
+      g_array_append_val (pp_planned, planned);
+      g_array_append_val (pp_rehearsed, rehearsed);
+    }
+}
+
+/* time taken by the slides start .. end - 1 */
+gfloat
+pp_slides_time (gint start,
+                gint end)
+{
+  gint split;
+
+  if (!pp_planned || pp_planned->len != pp_slide_count () + 1)
+    pp_timing_rebuild ();
+
+  start = CLAMP (start, 0, (gint) pp_slide_count ());
+  end = CLAMP (end, start, (gint) pp_slide_count ());
+  split = CLAMP (pp_slideno + 1, start, end);
+
+  return g_array_index (pp_rehearsed, gdouble, split) -
+         g_array_index (pp_rehearsed, gdouble, start) +
+         g_array_index (pp_planned, gdouble, end) -
+         g_array_index (pp_planned, gdouble, split);
+}
+
+/* account time spent on a slide while rehearsing */
+void
+pp_rehearse_add (gint   slideno,
+                 gfloat seconds)
+{
+  PinPointPoint *point = pp_slide_nth (slideno);
+  gdouble        delta;
+  guint          i;
+
+  if (!point)
+    return;
+
+  delta = -slide_rehearsed_time (point);
+  point->new_duration += seconds;
+  delta += slide_rehearsed_time (point);
+
+  if (!pp_rehearsed || pp_rehearsed->len != pp_slide_count () + 1)
+    {
+      pp_timing_rebuild ();
+      return;
+    }
+
+  /* only the sums past this slide change */
+  for (i = slideno + 1; i < pp_rehearsed->len; i++)
+    g_array_index (pp_rehearsed, gdouble, i) += delta;
+}
+
+/*
+ * Assets
+ *
+ * Background files are resolved against the directory of the presentation
+ * once per name. Names that lead to the same file, like a relative and an
+ * absolute path or a symlink, share one asset. Resolving a new name queries
+ * the file, in the main thread; the names of a reload that were already
+ * known are not queried again.
+ *
+ * After each parse and stream drop, the assets no slide uses any more are
+ * swept: the renderer lets go of what it kept for them, and those nothing
+ * references then are freed.
+ */
+
+static GHashTable *pp_assets_by_name = NULL; /* as written in the slides */
+static GHashTable *pp_assets_by_id   = NULL; /* G_FILE_ATTRIBUTE_ID_FILE */
+
+static void
+pp_assets_init (void)
+{
+  if (pp_assets_by_name)
+    return;
+
+  pp_assets_by_name = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                             g_free, NULL);
+  pp_assets_by_id = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                           g_free, NULL);
+}
+
+static gint64
+pp_file_mtime (const char *path)
+{
+  GStatBuf st;
+
+  return g_stat (path, &st) == 0 ? (gint64) st.st_mtime : -1;
+}
+
+PinPointAsset *
+pp_asset_lookup (const char *name)
+{
+  PinPointAsset *asset;
+  GFile         *file;
+  GFileInfo     *info;
+  const char    *id = NULL;
+
+  pp_assets_init ();
+
+  asset = g_hash_table_lookup (pp_assets_by_name, name);
+  if (asset)
+    return asset;
+
+  if (pp_basedir)
+    file = g_file_resolve_relative_path (pp_basedir, name);
+  else
+    file = g_file_new_for_path (name);
+
+  info = g_file_query_info (file, G_FILE_ATTRIBUTE_ID_FILE,
+                            G_FILE_QUERY_INFO_NONE, NULL, NULL);
+  if (info)
+    id = g_file_info_get_attribute_string (info, G_FILE_ATTRIBUTE_ID_FILE);
+  if (id)
+    asset = g_hash_table_lookup (pp_assets_by_id, id);
+
+  if (!asset)
+    {
+      asset = g_new0 (PinPointAsset, 1);
+      asset->mtime = -1;
+      asset->path = g_file_get_path (file);
+      if (!asset->path)
+        asset->path = g_strdup (name);
+      if (id)
+        g_hash_table_insert (pp_assets_by_id, g_strdup (id), asset);
+    }
+  g_hash_table_insert (pp_assets_by_name, g_strdup (name), asset);
+
+  if (info)
+    g_object_unref (info);
+  g_object_unref (file);
+
+  return asset;
+}
+
+PinPointAsset *
+pp_asset_ref (PinPointAsset *asset)
+{
+  g_atomic_int_inc (&asset->refs);
+  return asset;
+}
+
+/* the asset stays until the next sweep finds it unused */
+void
+pp_asset_unref (PinPointAsset *asset)
+{
+  g_atomic_int_add (&asset->refs, -1);
+}
+
+static gboolean
+pp_asset_is_dead (gpointer key,
+                  gpointer value,
+                  gpointer user_data)
+{
+  PinPointAsset *asset = value;
+
+  if (asset->used || g_atomic_int_get (&asset->refs))
+    return FALSE;
+
+  g_hash_table_add (user_data, asset);
+  return TRUE;
+}
+
+static void
+pp_assets_sweep (PinPointRenderer *renderer)
+{
+  GHashTableIter  iter;
+  GHashTable     *dead;
+  PinPointAsset  *asset;
+  guint           i, total;
+
+  if (!pp_assets_by_name)
+    return;
+
+  g_hash_table_iter_init (&iter, pp_assets_by_name);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &asset))
+    asset->used = FALSE;
+  if (default_point.asset)
+    default_point.asset->used = TRUE;
+  for (i = 0; i < pp_slide_count (); i++)
+    if (pp_slide_nth (i)->asset)
+      pp_slide_nth (i)->asset->used = TRUE;
+
+  if (renderer && renderer->release_assets)
+    renderer->release_assets (renderer);
+
+  /* an asset can be in both tables, under several names */
+  dead = g_hash_table_new (NULL, NULL);
+  total = g_hash_table_size (pp_assets_by_name);
+  g_hash_table_foreach_remove (pp_assets_by_name, pp_asset_is_dead, dead);
+  g_hash_table_foreach_remove (pp_assets_by_id, pp_asset_is_dead, dead);
+
+  if (g_hash_table_size (dead))
+    g_debug ("freed %u assets, %u names left", g_hash_table_size (dead),
+             total - g_hash_table_size (dead));
+
+  g_hash_table_iter_init (&iter, dead);
+  while (g_hash_table_iter_next (&iter, (gpointer *) &asset, NULL))
+    {
+      g_free (asset->path);
+      g_free (asset);
+    }
+  g_hash_table_destroy (dead);
+}
+
+/* the size of an image from its header, without decoding it. A size that
+ * came from the parse cache is kept while the file has the same mtime. */
+gboolean
+pp_asset_get_size (PinPointAsset *asset,
+                   gint          *width,
+                   gint          *height)
+{
+  if (!asset->probed)
+    {
+      gint64 mtime = pp_file_mtime (asset->path);
+
+      asset->probed = TRUE;
+      if (mtime < 0 || mtime != asset->mtime)
+        {
+          asset->mtime = mtime;
+          if (!gdk_pixbuf_get_file_info (asset->path,
+                                         &asset->width, &asset->height))
+            asset->width = asset->height = 0;
+          pp_cache_probed = TRUE;
+        }
+    }
+
+  *width = asset->width;
+  *height = asset->height;
+  return asset->width > 0 && asset->height > 0;
+}
+
+static void
+pin_point_set_asset (PinPointPoint *point)
+{
+  switch (point->bg_type)
+    {
+    case PP_BG_IMAGE:
+    case PP_BG_VIDEO:
+    case PP_BG_SVG:
+      point->asset = pp_asset_lookup (point->bg);
+      break;
+    default:
+      point->asset = NULL;
+      break;
+    }
+}
+
 /*
  * Cross-renderer helpers
  */
@@ -423,76 +1006,139 @@ parse_resolution (PPResolution *r,
     r->width = r->height = 0;
 }
 
+/* The [settings] pinpoint knows about, shared by parse_setting () and
+ * serialize_slide_config (). Anything else in brackets is the background.
+ */
+
+typedef enum
+{
+  PP_SETTING_STRING,
+  PP_SETTING_FLOAT,
+  PP_SETTING_INT,
+  PP_SETTING_RESOLUTION,
+  PP_SETTING_ENUM,
+  PP_SETTING_FLAG        /* [name] without a value, stores value */
+} PPSettingType;
+
+typedef struct
+{
+  const char            *name;
+  PPSettingType          type;
+  glong                  offset;  /* of the field in PinPointPoint */
+  int                    value;   /* PP_SETTING_FLAG */
+  const EnumDescription *desc;    /* PP_SETTING_ENUM */
+} PPSetting;
+
+#define SETTING(n,t,f) { n, PP_SETTING_##t, G_STRUCT_OFFSET (PinPointPoint, f) }
+#define ENUM(n,t,f)    { n, PP_SETTING_ENUM, G_STRUCT_OFFSET (PinPointPoint, f), \
+                         0, t##_desc }
+#define FLAG(n,f,v)    { n, PP_SETTING_FLAG, G_STRUCT_OFFSET (PinPointPoint, f), v }
+
+static const PPSetting pp_settings[] =
+{
+  SETTING ("stage-color",       STRING,     stage_color),
+  SETTING ("font",              STRING,     font),
+  SETTING ("notes-font",        STRING,     notes_font),
+  SETTING ("notes-font-size",   STRING,     notes_font_size),
+  SETTING ("text-color",        STRING,     text_color),
+  ENUM    ("text-align",        PPTextAlign, text_align),
+  SETTING ("shading-color",     STRING,     shading_color),
+  SETTING ("shading-opacity",   FLOAT,      shading_opacity),
+  SETTING ("duration",          FLOAT,      duration),
+  SETTING ("command",           STRING,     command),
+  SETTING ("transition",        STRING,     transition),
+  SETTING ("video-start",       FLOAT,      video_start),
+  SETTING ("camera-framerate",  INT,        camera_framerate),
+  SETTING ("camera-resolution", RESOLUTION, camera_resolution),
+  FLAG    ("fill",         bg_scale,   PP_BG_FILL),
+  FLAG    ("fit",          bg_scale,   PP_BG_FIT),
+  FLAG    ("stretch",      bg_scale,   PP_BG_STRETCH),
+  FLAG    ("unscaled",     bg_scale,   PP_BG_UNSCALED),
+  FLAG    ("center",       position,   CLUTTER_GRAVITY_CENTER),
+  FLAG    ("top",          position,   CLUTTER_GRAVITY_NORTH),
+  FLAG    ("bottom",       position,   CLUTTER_GRAVITY_SOUTH),
+  FLAG    ("left",         position,   CLUTTER_GRAVITY_WEST),
+  FLAG    ("right",        position,   CLUTTER_GRAVITY_EAST),
+  FLAG    ("top-left",     position,   CLUTTER_GRAVITY_NORTH_WEST),
+  FLAG    ("top-right",    position,   CLUTTER_GRAVITY_NORTH_EAST),
+  FLAG    ("bottom-left",  position,   CLUTTER_GRAVITY_SOUTH_WEST),
+  FLAG    ("bottom-right", position,   CLUTTER_GRAVITY_SOUTH_EAST),
+  FLAG    ("no-markup",    use_markup, FALSE),
+  FLAG    ("markup",       use_markup, TRUE),
+};
+
+#undef SETTING
+#undef ENUM
+#undef FLAG
+
+static const PPSetting *
+pp_setting_lookup (const char *name)
+{
+  static GHashTable *settings = NULL;
+
+  if (G_UNLIKELY (!settings))
+    {
+      guint i;
+
+      settings = g_hash_table_new (g_str_hash, g_str_equal);
+      for (i = 0; i < G_N_ELEMENTS (pp_settings); i++)
+        g_hash_table_insert (settings, (gpointer) pp_settings[i].name,
+                             (gpointer) &pp_settings[i]);
+    }
+
+  return g_hash_table_lookup (settings, name);
+}
+
+/* setting is a scratch buffer, it is split at '=' while looking it up */
 static void
 parse_setting (PinPointPoint *point,
-               const char    *setting)
+               char          *setting)
 {
-/* C Preprocessor macros implemeting a mini language for interpreting
- * pinpoint key=value pairs
- */
+  const PPSetting *s;
+  char            *value = strchr (setting, '=');
 
-#define START_PARSER if (0) {
-#define DEFAULT      } else {
-#define END_PARSER   }
-#define IF_PREFIX(prefix) } else if (g_str_has_prefix (setting, prefix)) {
-#define IF_EQUAL(string) } else if (g_str_equal (setting, string)) {
-#define STRING  g_intern_string (strchr (setting, '=') + 1)
-#define INT     atoi (strchr (setting, '=') + 1)
-#define FLOAT   g_ascii_strtod (strchr (setting, '=') + 1, NULL)
-#define RESOLUTION(r) parse_resolution (&r, strchr (setting, '=') + 1)
-#define ENUM(r,t,s) \
-  do { \
-      int _i; \
-      EnumDescription *_d = t##_desc; \
-      r = _d[0].value; \
-      for (_i = 0; _d[_i].name; _i++) \
-        if (g_strcmp0 (_d[_i].name, s) == 0) \
-          r = _d[_i].value; \
-  } while (0)
-
-  START_PARSER
-  IF_PREFIX("stage-color=") point->stage_color = STRING;
-  IF_PREFIX("font=")        point->font = STRING;
-  IF_PREFIX("notes-font=")  point->notes_font = STRING;
-  IF_PREFIX("notes-font-size=")  point->notes_font_size = STRING;
-  IF_PREFIX("text-color=")  point->text_color = STRING;
-  IF_PREFIX("text-align=")  ENUM(point->text_align, PPTextAlign, STRING);
-  IF_PREFIX("shading-color=") point->shading_color = STRING;
-  IF_PREFIX("shading-opacity=") point->shading_opacity = FLOAT;
-  IF_PREFIX("duration=")   point->duration = FLOAT;
-  IF_PREFIX("command=")    point->command = STRING;
-  IF_PREFIX("transition=") point->transition = STRING;
-  IF_PREFIX("camera-framerate=")  point->camera_framerate = INT;
-  IF_PREFIX("camera-resolution=") RESOLUTION (point->camera_resolution);
-  IF_EQUAL("fill")         point->bg_scale = PP_BG_FILL;
-  IF_EQUAL("fit")          point->bg_scale = PP_BG_FIT;
-  IF_EQUAL("stretch")      point->bg_scale = PP_BG_STRETCH;
-  IF_EQUAL("unscaled")     point->bg_scale = PP_BG_UNSCALED;
-  IF_EQUAL("center")       point->position = CLUTTER_GRAVITY_CENTER;
-  IF_EQUAL("top")          point->position = CLUTTER_GRAVITY_NORTH;
-  IF_EQUAL("bottom")       point->position = CLUTTER_GRAVITY_SOUTH;
-  IF_EQUAL("left")         point->position = CLUTTER_GRAVITY_WEST;
-  IF_EQUAL("right")        point->position = CLUTTER_GRAVITY_EAST;
-  IF_EQUAL("top-left")     point->position = CLUTTER_GRAVITY_NORTH_WEST;
-  IF_EQUAL("top-right")    point->position = CLUTTER_GRAVITY_NORTH_EAST;
-  IF_EQUAL("bottom-left")  point->position = CLUTTER_GRAVITY_SOUTH_WEST;
-  IF_EQUAL("bottom-right") point->position = CLUTTER_GRAVITY_SOUTH_EAST;
-  IF_EQUAL("no-markup")    point->use_markup = FALSE;
-  IF_EQUAL("markup")       point->use_markup = TRUE;
-  DEFAULT                  point->bg = g_intern_string (setting);
-  END_PARSER
-
-/* undefine the overrides, returning us to regular C */
-#undef START_PARSER
-#undef END_PARSER
-#undef DEFAULT
-#undef IF_PREFIX
-#undef IF_EQUAL
-#undef FLOAT
-#undef STRING
-#undef INT
-#undef ENUM
-#undef RESOLUTION
+  if (value)
+    *value = '\0';
+  s = pp_setting_lookup (setting);
+  if (value)
+    *value++ = '=';
+
+  if (!s || (s->type == PP_SETTING_FLAG) != (value == NULL))
+    {
+      point->bg = g_string_chunk_insert_const (pp_strings, setting);
+      return;
+    }
+
+  switch (s->type)
+    {
+    case PP_SETTING_STRING:
+      G_STRUCT_MEMBER (const char *, point, s->offset) =
+        g_string_chunk_insert_const (pp_strings, value);
+      break;
+    case PP_SETTING_FLOAT:
+      G_STRUCT_MEMBER (gfloat, point, s->offset) = g_ascii_strtod (value, NULL);
+      break;
+    case PP_SETTING_INT:
+      G_STRUCT_MEMBER (gint, point, s->offset) = atoi (value);
+      break;
+    case PP_SETTING_RESOLUTION:
+      parse_resolution (G_STRUCT_MEMBER_P (point, s->offset), value);
+      break;
+    case PP_SETTING_ENUM:
+      {
+        const EnumDescription *d;
+
+        /* unknown values fall back to the first one */
+        G_STRUCT_MEMBER (int, point, s->offset) = s->desc[0].value;
+        for (d = s->desc; d->name; d++)
+          if (g_str_equal (d->name, value))
+            G_STRUCT_MEMBER (int, point, s->offset) = d->value;
+      }
+      break;
+    case PP_SETTING_FLAG:
+      G_STRUCT_MEMBER (int, point, s->offset) = s->value;
+      break;
+    }
 }
 
 static void
@@ -504,19 +1150,23 @@ parse_config (PinPointPoint *point,
 
   for (p = config; *p; p++)
     {
+      gsize len;
+
       if (*p != '[')
         continue;
 
       p++;
-      g_string_truncate (str, 0);
-      while (*p && *p != ']' && *p != '\n')
+      len = strcspn (p, "]\n");
+      if (p[len] == ']')
         {
-          g_string_append_c (str, *p);
-          p++;
+          g_string_truncate (str, 0);
+          g_string_append_len (str, p, len);
+          parse_setting (point, str->str);
         }
 
-      if (*p == ']')
-        parse_setting (point, str->str);
+      p += len;
+      if (!*p)
+        break;
     }
   g_string_free (str, TRUE);
 }
@@ -525,38 +1175,149 @@ static void
 pin_point_free (PinPointRenderer *renderer,
                 PinPointPoint    *point)
 {
-  if (renderer->free_data)
-    renderer->free_data (renderer, point->data);
-  if (point->speaker_notes)
-    {
-      g_free (point->speaker_notes);
-    }
+  if (point->ready)
+    pin_point_unmake (renderer, point);
   g_free (point);
 }
 
 static PinPointPoint *
-pin_point_new (PinPointRenderer *renderer)
+pin_point_new (void)
 {
   PinPointPoint *point;
 
   point = g_new0 (PinPointPoint, 1);
   *point = default_point;
 
-  if (renderer->allocate_data)
-      point->data = renderer->allocate_data (renderer);
-
   return point;
 }
 
-static gboolean
-pp_is_color (const char *string)
+/* hand a freshly parsed point over to the renderer */
+static void
+pin_point_make (PinPointRenderer *renderer,
+                PinPointPoint    *point)
 {
-  ClutterColor color;
-  return clutter_color_from_string (&color, string);
+  if (renderer->allocate_data)
+      point->data = renderer->allocate_data (renderer);
+
+  renderer->make_point (renderer, point);
+  point->ready = TRUE;
+  pp_made++;
 }
 
-static gboolean
-str_has_video_suffix (const char *string)
+/* let go of the renderer data, the slide is made again when needed */
+static void
+pin_point_unmake (PinPointRenderer *renderer,
+                  PinPointPoint    *point)
+{
+  if (renderer->free_data && point->data)
+    renderer->free_data (renderer, point->data);
+  point->data = NULL;
+  point->ready = FALSE;
+  pp_made--;
+
+  /* nothing is left to animate */
+  if (point->animating)
+    {
+      point->animating = FALSE;
+      pp_animating = g_list_remove (pp_animating, point);
+    }
+}
+
+/* Take the parsed settings of an unchanged slide while keeping the renderer
+ * data and the rehearsal timing of the point it replaces.
+ */
+static void
+pin_point_update (PinPointPoint *point,
+                  PinPointPoint *parsed)
+{
+  void     *data         = point->data;
+  gfloat    new_duration = point->new_duration;
+  gboolean  ready        = point->ready;
+  gboolean  animating    = point->animating;
+
+  *point = *parsed;
+  point->data = data;
+  point->new_duration = new_duration;
+  point->ready = ready;
+  point->animating = animating;
+
+  parsed->data = NULL;
+}
+
+/* Slides are matched against the previous parse by their source text, so that
+ * only added, removed or edited slides go through make_point ()/free_data ()
+ * on reload.
+ */
+static GHashTable *
+pin_point_table_new (GPtrArray *points)
+{
+  GHashTable *table;
+  guint       i;
+
+  table = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                 g_free, (GDestroyNotify) g_queue_free);
+
+  for (i = 0; i < points->len; i++)
+    {
+      PinPointPoint *point = g_ptr_array_index (points, i);
+      char          *key   = g_strndup (point->source, point->source_len);
+      GQueue        *queue = g_hash_table_lookup (table, key);
+
+      if (queue)
+        {
+          g_free (key);
+        }
+      else
+        {
+          queue = g_queue_new ();
+          g_hash_table_insert (table, key, queue);
+        }
+      g_queue_push_tail (queue, point);
+    }
+
+  return table;
+}
+
+static PinPointPoint *
+pin_point_table_take (GHashTable    *table,
+                      PinPointPoint *point)
+{
+  char   *key   = g_strndup (point->source, point->source_len);
+  GQueue *queue = g_hash_table_lookup (table, key);
+
+  g_free (key);
+  if (!queue)
+    return NULL;
+  return g_queue_pop_head (queue);
+}
+
+static void
+pin_point_table_free (PinPointRenderer *renderer,
+                      GHashTable       *table)
+{
+  GHashTableIter iter;
+  GQueue        *queue;
+
+  g_hash_table_iter_init (&iter, table);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &queue))
+    {
+      PinPointPoint *point;
+
+      while ((point = g_queue_pop_head (queue)))
+        pin_point_free (renderer, point);
+    }
+  g_hash_table_destroy (table);
+}
+
+static gboolean
+pp_is_color (const char *string)
+{
+  ClutterColor color;
+  return clutter_color_from_string (&color, string);
+}
+
+static gboolean
+str_has_video_suffix (const char *string)
 {
   char *video_extensions[] =
     {".avi", ".ogg", ".ogv", ".mpg",  ".flv", ".mpeg",
@@ -576,101 +1337,70 @@ static void serialize_slide_config (GString       *str,
                                     PinPointPoint *reference,
                                     const char    *separator)
 {
-#define STRING(v,n) \
-  if (point->v != reference->v) \
-    g_string_append_printf (str, "%s[" n "%s]", separator, point->v)
-#define INT(v,n) \
-  if (point->v != reference->v) \
-    g_string_append_printf (str, "%s[" n "%d]", separator, point->v)
-#define FLOAT(v,n) \
-  if (point->v != reference->v) \
-    g_string_append_printf (str, "%s[" n "%f]", separator, point->v)
+  char  buf[G_ASCII_DTOSTR_BUF_SIZE];
+  guint i;
 
-  STRING(stage_color, "stage-color=");
-  STRING(bg, "");
+  if (point->bg && point->bg != reference->bg)
+    g_string_append_printf (str, "%s[%s]", separator, point->bg);
 
-  if (point->bg_scale != reference->bg_scale)
+  for (i = 0; i < G_N_ELEMENTS (pp_settings); i++)
     {
-      g_string_append (str, separator);
-      switch (point->bg_scale)
-        {
-          case PP_BG_FILL:     g_string_append (str, "[fill]");     break;
-          case PP_BG_FIT:      g_string_append (str, "[fit]");      break;
-          case PP_BG_STRETCH:  g_string_append (str, "[stretch]");  break;
-          case PP_BG_UNSCALED: g_string_append (str, "[unscaled]"); break;
-        }
-    }
+      const PPSetting *s = &pp_settings[i];
 
-  if (point->text_align != reference->text_align)
-    {
-      g_string_append (str, separator);
-      switch (point->text_align)
+#define FIELD(t,p) G_STRUCT_MEMBER (t, p, s->offset)
+      switch (s->type)
         {
-          case PP_TEXT_LEFT:  g_string_append (str, "[text-align=left]");break;
-          case PP_TEXT_CENTER:g_string_append (str, "[text-align=center]");break;
-          case PP_TEXT_RIGHT: g_string_append (str, "[text-align=right]");break;
-        }
-    }
-
-  if (point->position != reference->position)
-    {
-      g_string_append (str, separator);
-      switch (point->position)
-        {
-          case CLUTTER_GRAVITY_NONE:
+        case PP_SETTING_STRING:
+          if (FIELD (const char *, point) &&
+              FIELD (const char *, point) != FIELD (const char *, reference))
+            g_string_append_printf (str, "%s[%s=%s]", separator, s->name,
+                                    FIELD (const char *, point));
+          break;
+        case PP_SETTING_FLOAT:
+          /* XXX: a duration of 0 probably needs special treatment */
+          if (s->offset == G_STRUCT_OFFSET (PinPointPoint, duration) &&
+              point->duration == 0.0)
             break;
-          case CLUTTER_GRAVITY_CENTER:
-            g_string_append (str, "[center]");break;
-          case CLUTTER_GRAVITY_NORTH:
-            g_string_append (str, "[top]");break;
-          case CLUTTER_GRAVITY_SOUTH:
-            g_string_append (str, "[bottom]");break;
-          case CLUTTER_GRAVITY_WEST:
-            g_string_append (str, "[left]");break;
-          case CLUTTER_GRAVITY_EAST:
-            g_string_append (str, "[right]");break;
-          case CLUTTER_GRAVITY_NORTH_WEST:
-            g_string_append (str, "[top-left]");break;
-          case CLUTTER_GRAVITY_NORTH_EAST:
-            g_string_append (str, "[top-right]");break;
-          case CLUTTER_GRAVITY_SOUTH_WEST:
-            g_string_append (str, "[bottom-left]");break;
-          case CLUTTER_GRAVITY_SOUTH_EAST:
-            g_string_append (str, "[bottom-right]");break;
-        }
-    }
-
-  STRING(font,"font=");
-  STRING(text_color,"text-color=");
-  STRING(shading_color,"shading-color=");
-  FLOAT(shading_opacity, "shading-opacity=");
-
-  STRING(transition,"transition=");
-  STRING(command,"command=");
-  if (point->duration != 0.0)
-    FLOAT(duration, "duration="); /* XXX: probably needs special treatment */
-
-  INT(camera_framerate, "camera-framerate=");
-  if (point->camera_resolution.width != reference->camera_resolution.width &&
-      point->camera_resolution.height != reference->camera_resolution.height)
-    {
-        g_string_append_printf (str, "[camera-resolution=%dx%d]",
-                                point->camera_resolution.width,
-                                point->camera_resolution.height);
-    }
+          if (FIELD (gfloat, point) != FIELD (gfloat, reference))
+            g_string_append_printf (str, "%s[%s=%s]", separator, s->name,
+                                    g_ascii_formatd (buf, sizeof (buf), "%f",
+                                                     FIELD (gfloat, point)));
+          break;
+        case PP_SETTING_INT:
+          if (FIELD (gint, point) != FIELD (gint, reference))
+            g_string_append_printf (str, "%s[%s=%d]", separator, s->name,
+                                    FIELD (gint, point));
+          break;
+        case PP_SETTING_RESOLUTION:
+          if (FIELD (PPResolution, point).width !=
+                FIELD (PPResolution, reference).width ||
+              FIELD (PPResolution, point).height !=
+                FIELD (PPResolution, reference).height)
+            g_string_append_printf (str, "%s[%s=%dx%d]", separator, s->name,
+                                    FIELD (PPResolution, point).width,
+                                    FIELD (PPResolution, point).height);
+          break;
+        case PP_SETTING_ENUM:
+          if (FIELD (int, point) != FIELD (int, reference))
+            {
+              const EnumDescription *d;
 
-  if (point->use_markup != reference->use_markup)
-    {
-      g_string_append (str, separator);
-      if (point->use_markup)
-        g_string_append (str, "[markup]");
-      else
-        g_string_append (str, "[no-markup]");
+              for (d = s->desc; d->name; d++)
+                if (d->value == FIELD (int, point))
+                  break;
+              if (d->name)
+                g_string_append_printf (str, "%s[%s=%s]", separator,
+                                        s->name, d->name);
+            }
+          break;
+        case PP_SETTING_FLAG:
+          if (FIELD (int, point) != FIELD (int, reference) &&
+              FIELD (int, point) == s->value)
+            g_string_append_printf (str, "%s[%s]", separator, s->name);
+          break;
+        }
+#undef FIELD
     }
-
-#undef FLOAT
-#undef INT
-#undef STRING
 }
 
 
@@ -708,82 +1438,513 @@ static char * pp_serialize (void)
 {
   GString *str = g_string_new ("#!/usr/bin/env pinpoint\n");
   char *ret;
-  GList *iter;
+  guint i;
 
   serialize_slide_config (str, &default_point, &pin_default_point, "\n");
 
-  for (iter = pp_slides; iter; iter = iter->next)
+  for (i = 0; i < pp_slide_count (); i++)
     {
-      serialize_slide (str, iter->data);
+      serialize_slide (str, pp_slide_nth (i));
     }
   ret = str->str;
   g_string_free (str, FALSE);
   return ret;
 }
 
-void
-pp_parse_slides (PinPointRenderer *renderer,
-                 const char       *slide_src)
+/*
+ * Parse cache
+ *
+ * The parsed points of a presentation are kept in the user's cache directory
+ * so that starting it again unchanged skips the parser. The cache is only
+ * used while the checksum of the source and of the built-in defaults it was
+ * made from still match.
+ */
+
+#define PP_CACHE_MAGIC   "PPCACHE3"
+#define PP_CACHE_NULL    -1
+#define PP_CACHE_DEFAULT -2 /* the built-in default string itself, which
+                               pp_serialize () tells apart by address */
+
+static const gsize pp_cache_strings[] =
 {
-  const char *p;
-  int         slideno     = 0;
-  gboolean    done        = FALSE;
-  gboolean    startofline = TRUE;
-  gboolean    gotconfig   = FALSE;
-  GString    *slide_str   = g_string_new ("");
-  GString    *setting_str = g_string_new ("");
-  GString    *notes_str   = g_string_new ("");
-  GList      *s;
-  PinPointPoint *point, *next_point;
+  G_STRUCT_OFFSET (PinPointPoint, stage_color),
+  G_STRUCT_OFFSET (PinPointPoint, bg),
+  G_STRUCT_OFFSET (PinPointPoint, text),
+  G_STRUCT_OFFSET (PinPointPoint, font),
+  G_STRUCT_OFFSET (PinPointPoint, notes_font),
+  G_STRUCT_OFFSET (PinPointPoint, notes_font_size),
+  G_STRUCT_OFFSET (PinPointPoint, text_color),
+  G_STRUCT_OFFSET (PinPointPoint, speaker_notes),
+  G_STRUCT_OFFSET (PinPointPoint, shading_color),
+  G_STRUCT_OFFSET (PinPointPoint, transition),
+  G_STRUCT_OFFSET (PinPointPoint, command),
+};
 
-  if (renderer->source)
+#define POINT_STRING(point,i) \
+  G_STRUCT_MEMBER (const char *, point, pp_cache_strings[i])
+
+typedef struct
+{
+  char    magic[8];
+  char    checksum[48];     /* SHA-1 of the source and the built-in defaults */
+  guint32 n_records;        /* the presentation defaults, then the slides */
+  guint32 strings_len;      /* NUL separated strings after the records */
+} PPCacheHeader;
+
+typedef struct
+{
+  gint32  strings[G_N_ELEMENTS (pp_cache_strings)];
+  gint32  source;           /* offset in the source, PP_CACHE_NULL if none */
+  guint32 source_len;
+  gint32  bg_type;
+  gint32  bg_scale;
+  gint32  position;
+  gint32  text_align;
+  gint32  use_markup;
+  gfloat  duration;
+  gfloat  shading_opacity;
+  gfloat  video_start;
+  gint32  camera_framerate;
+  gint32  camera_width;
+  gint32  camera_height;
+  gint32  asset_path;       /* resolved path in the strings, or PP_CACHE_NULL */
+  gint32  asset_width;      /* as probed, -1 when it was not */
+  gint32  asset_height;
+  gint64  asset_mtime;      /* of the file when it was probed */
+} PPCacheRecord;
+
+static void
+pp_cache_init (GFile *file)
+{
+  char *uri  = g_file_get_uri (file);
+  char *hash = g_compute_checksum_for_string (G_CHECKSUM_SHA1, uri, -1);
+  char *name = g_strconcat (hash, ".cache", NULL);
+
+  pp_cache_file = g_build_filename (g_get_user_cache_dir (), "pinpoint",
+                                    name, NULL);
+  g_free (name);
+  g_free (hash);
+  g_free (uri);
+}
+
+static char *
+pp_cache_checksum (const char *slide_src)
+{
+  GChecksum *checksum = g_checksum_new (G_CHECKSUM_SHA1);
+  char      *ret;
+
+  g_checksum_update (checksum, (const guchar *) slide_src, -1);
+  g_checksum_update (checksum,
+                     (const guchar *) pin_default_point.stage_color, -1);
+  ret = g_strdup (g_checksum_get_string (checksum));
+  g_checksum_free (checksum);
+
+  return ret;
+}
+
+static gint32
+pp_cache_write_string (const char *str,
+                       GString    *strings,
+                       GHashTable *offsets)
+{
+  gpointer offset;
+
+  if (g_hash_table_lookup_extended (offsets, str, NULL, &offset))
+    return GPOINTER_TO_INT (offset);
+
+  offset = GINT_TO_POINTER (strings->len);
+  g_hash_table_insert (offsets, (gpointer) str, offset);
+  g_string_append_len (strings, str, strlen (str) + 1);
+  return GPOINTER_TO_INT (offset);
+}
+
+static void
+pp_cache_write_record (PPCacheRecord *record,
+                       PinPointPoint *point,
+                       const char    *slide_src,
+                       GString       *strings,
+                       GHashTable    *offsets)
+{
+  PinPointAsset *asset = point->asset;
+  guint          i;
+
+  memset (record, 0, sizeof (PPCacheRecord));
+
+  for (i = 0; i < G_N_ELEMENTS (pp_cache_strings); i++)
     {
-      gboolean start_of_line = TRUE;
-      int pos;
-      int lineno=0;
-      /* compute slide no that has changed */
-      for (pos = 0, slideno = 0;
-           slide_src[pos] &&
-           renderer->source[pos] &&
-           slide_src[pos]==renderer->source[pos]
-           ; pos ++)
+      const char *str = POINT_STRING (point, i);
+
+      if (!str)
+        record->strings[i] = PP_CACHE_NULL;
+      else if (str == POINT_STRING (&pin_default_point, i))
+        record->strings[i] = PP_CACHE_DEFAULT;
+      else
+        record->strings[i] = pp_cache_write_string (str, strings, offsets);
+    }
+
+  record->source = point->source ? point->source - slide_src : PP_CACHE_NULL;
+  record->source_len = point->source_len;
+  record->bg_type = point->bg_type;
+  record->bg_scale = point->bg_scale;
+  record->position = point->position;
+  record->text_align = point->text_align;
+  record->use_markup = point->use_markup;
+  record->duration = point->duration;
+  record->shading_opacity = point->shading_opacity;
+  record->video_start = point->video_start;
+  record->camera_framerate = point->camera_framerate;
+  record->camera_width = point->camera_resolution.width;
+  record->camera_height = point->camera_resolution.height;
+
+  record->asset_path = PP_CACHE_NULL;
+  record->asset_width = record->asset_height = -1;
+  record->asset_mtime = -1;
+  if (asset)
+    {
+      record->asset_path = pp_cache_write_string (asset->path,
+                                                  strings, offsets);
+      if (asset->probed && asset->mtime >= 0)
         {
-          switch (slide_src[pos])
-            {
-              case '\n':
-                start_of_line = TRUE;
-                lineno++;
-                break;
-              case '-':
-                if (start_of_line)
-                  slideno++;
-              default:
-                start_of_line = FALSE;
-            }
+          record->asset_width = asset->width;
+          record->asset_height = asset->height;
+          record->asset_mtime = asset->mtime;
         }
-      slideno-=1;
-      g_free (renderer->source);
     }
-  renderer->source = g_strdup (slide_src);
+}
+
+static gboolean
+pp_cache_check_record (const PPCacheRecord *record,
+                       gsize                source_len,
+                       gsize                strings_len)
+{
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (pp_cache_strings); i++)
+    if (record->strings[i] < PP_CACHE_DEFAULT ||
+        record->strings[i] >= (gint32) strings_len)
+      return FALSE;
+
+  /* the renderers assert on values outside of the enums */
+  if (record->bg_type < PP_BG_NONE || record->bg_type > PP_BG_SVG ||
+      record->bg_scale < PP_BG_UNSCALED || record->bg_scale > PP_BG_STRETCH ||
+      record->position < CLUTTER_GRAVITY_NONE ||
+      record->position > CLUTTER_GRAVITY_CENTER ||
+      (record->text_align != PP_TEXT_LEFT &&
+       record->text_align != PP_TEXT_CENTER &&
+       record->text_align != PP_TEXT_RIGHT))
+    return FALSE;
+
+  if (record->asset_path != PP_CACHE_NULL &&
+      (record->asset_path < 0 ||
+       record->asset_path >= (gint32) strings_len ||
+       record->strings[1] < 0 ||
+       (record->bg_type != PP_BG_IMAGE &&
+        record->bg_type != PP_BG_VIDEO &&
+        record->bg_type != PP_BG_SVG) ||
+       record->asset_width < -1 || record->asset_height < -1))
+    return FALSE;
+
+  if (record->source == PP_CACHE_NULL)
+    return TRUE;
+  return record->source >= 0 &&
+         record->source + (gsize) record->source_len <= source_len;
+}
+
+/* the asset of a cached point, without looking the file up again; its size
+ * is only checked against the file's mtime when it is first asked for */
+static PinPointAsset *
+pp_cache_read_asset (const PPCacheRecord *record,
+                     const char          *name,
+                     const char          *strings,
+                     GHashTable          *by_path)
+{
+  const char    *path = strings + record->asset_path;
+  PinPointAsset *asset;
+
+  pp_assets_init ();
+
+  asset = g_hash_table_lookup (pp_assets_by_name, name);
+  if (asset)
+    return asset;
+
+  asset = g_hash_table_lookup (by_path, path);
+  if (!asset)
+    {
+      asset = g_new0 (PinPointAsset, 1);
+      asset->path = g_strdup (path);
+      asset->mtime = -1;
+      if (record->asset_mtime >= 0)
+        {
+          asset->width = record->asset_width;
+          asset->height = record->asset_height;
+          asset->mtime = record->asset_mtime;
+        }
+      g_hash_table_insert (by_path, asset->path, asset);
+    }
+  g_hash_table_insert (pp_assets_by_name, g_strdup (name), asset);
+
+  return asset;
+}
+
+static void
+pp_cache_read_record (const PPCacheRecord *record,
+                      PinPointPoint       *point,
+                      const char          *slide_src,
+                      const char          *strings,
+                      GHashTable          *by_path)
+{
+  guint i;
+
+  memset (point, 0, sizeof (PinPointPoint));
+
+  for (i = 0; i < G_N_ELEMENTS (pp_cache_strings); i++)
+    {
+      switch (record->strings[i])
+        {
+        case PP_CACHE_NULL:
+          POINT_STRING (point, i) = NULL;
+          break;
+        case PP_CACHE_DEFAULT:
+          POINT_STRING (point, i) = POINT_STRING (&pin_default_point, i);
+          break;
+        default:
+          POINT_STRING (point, i) =
+            g_string_chunk_insert_const (pp_strings,
+                                         strings + record->strings[i]);
+          break;
+        }
+    }
+
+  if (record->source != PP_CACHE_NULL)
+    point->source = slide_src + record->source;
+  point->source_len = record->source_len;
+  point->bg_type = record->bg_type;
+  point->bg_scale = record->bg_scale;
+  point->position = record->position;
+  point->text_align = record->text_align;
+  point->use_markup = record->use_markup;
+  point->duration = record->duration;
+  point->shading_opacity = record->shading_opacity;
+  point->video_start = record->video_start;
+  point->camera_framerate = record->camera_framerate;
+  point->camera_resolution.width = record->camera_width;
+  point->camera_resolution.height = record->camera_height;
+  if (record->asset_path != PP_CACHE_NULL)
+    point->asset = pp_cache_read_asset (record, point->bg, strings, by_path);
+}
+
+static void
+pp_cache_save (const char *slide_src)
+{
+  PPCacheHeader  header;
+  GString       *records;
+  GString       *strings;
+  GHashTable    *offsets;
+  GError        *error = NULL;
+  char          *checksum;
+  char          *dir;
+  guint          i;
+
+  if (!pp_cache_file)
+    return;
+
+  /* a reload of unchanged text has nothing new to store, unless asset sizes
+   * were probed since */
+  checksum = pp_cache_checksum (slide_src);
+  if (pp_cache_stored && !strcmp (checksum, pp_cache_stored) &&
+      !pp_cache_probed)
+    {
+      g_free (checksum);
+      return;
+    }
+
+  records = g_string_new ("");
+  strings = g_string_new ("");
+  offsets = g_hash_table_new (g_str_hash, g_str_equal);
+
+  for (i = 0; i <= pp_slide_count (); i++)
+    {
+      PPCacheRecord record;
+
+      pp_cache_write_record (&record,
+                             i ? pp_slide_nth (i - 1) : &default_point,
+                             slide_src, strings, offsets);
+      g_string_append_len (records, (char *) &record, sizeof (record));
+    }
+
+  memset (&header, 0, sizeof (header));
+  memcpy (header.magic, PP_CACHE_MAGIC, sizeof (header.magic));
+  g_strlcpy (header.checksum, checksum, sizeof (header.checksum));
+  header.n_records = pp_slide_count () + 1;
+  header.strings_len = strings->len;
+
+  g_string_prepend_len (records, (char *) &header, sizeof (header));
+  g_string_append_len (records, strings->str, strings->len);
+
+  dir = g_path_get_dirname (pp_cache_file);
+  g_mkdir_with_parents (dir, 0700);
+  if (g_file_set_contents (pp_cache_file, records->str, records->len, &error))
+    {
+      g_free (pp_cache_stored);
+      pp_cache_stored = checksum;
+      pp_cache_probed = FALSE;
+    }
+  else
+    {
+      g_debug ("could not write the parse cache: %s", error->message);
+      g_clear_error (&error);
+      g_free (checksum);
+    }
+
+  g_free (dir);
+  g_hash_table_destroy (offsets);
+  g_string_free (strings, TRUE);
+  g_string_free (records, TRUE);
+}
+
+/* fills default_point and pp_slides from the cache, if it is still valid
+ * for slide_src */
+static gboolean
+pp_cache_load (const char *slide_src)
+{
+  const PPCacheHeader *header;
+  const PPCacheRecord *records;
+  const char          *strings;
+  GHashTable          *by_path;
+  char                *contents;
+  char                *checksum;
+  gsize                length;
+  gsize                source_len = strlen (slide_src);
+  gboolean             ret = FALSE;
+  guint                i;
+
+  if (!pp_cache_file ||
+      !g_file_get_contents (pp_cache_file, &contents, &length, NULL))
+    return FALSE;
+
+  header = (const PPCacheHeader *) contents;
+  records = (const PPCacheRecord *) (header + 1);
+  checksum = pp_cache_checksum (slide_src);
+
+  if (length < sizeof (PPCacheHeader) ||
+      memcmp (header->magic, PP_CACHE_MAGIC, sizeof (header->magic)) ||
+      strncmp (header->checksum, checksum, sizeof (header->checksum)) ||
+      header->n_records == 0 ||
+      header->n_records > (length - sizeof (PPCacheHeader)) /
+                          sizeof (PPCacheRecord) ||
+      header->strings_len == 0 ||
+      header->strings_len != length - sizeof (PPCacheHeader) -
+                             header->n_records * sizeof (PPCacheRecord) ||
+      contents[length - 1] != '\0')
+    goto out;
+
+  for (i = 0; i < header->n_records; i++)
+    if (!pp_cache_check_record (&records[i], source_len, header->strings_len))
+      goto out;
+
+  strings = (const char *) (records + header->n_records);
+  by_path = g_hash_table_new (g_str_hash, g_str_equal);
+
+  pp_cache_read_record (&records[0], &default_point, slide_src, strings,
+                        by_path);
+  for (i = 1; i < header->n_records; i++)
+    {
+      PinPointPoint *point = g_new (PinPointPoint, 1);
+
+      pp_cache_read_record (&records[i], point, slide_src, strings, by_path);
+      g_ptr_array_add (pp_slides, point);
+    }
+  g_hash_table_destroy (by_path);
+  g_free (pp_cache_stored);
+  pp_cache_stored = g_strdup (checksum);
+  ret = TRUE;
+
+out:
+  g_free (checksum);
+  g_free (contents);
+  return ret;
+}
+
+/* fill in what a point gets from the text of its slide */
+static void
+pin_point_finish (PinPointPoint *point,
+                  GString       *slide_str,
+                  GString       *notes_str)
+{
+  char  *str = slide_str->str;
+  gsize  len;
 
-  for (s = pp_slides; s; s = s->next)
-    pin_point_free (renderer, s->data);
+  if (point->bg && point->bg[0])
+    {
+      char *filename = g_strdup (point->bg);
+      int i = 0;
 
-  g_list_free (pp_slides);
-  pp_slides = NULL;
-  point = pin_point_new (renderer);
+      while (filename[i])
+        {
+          filename[i] = tolower(filename[i]);
+          i++;
+        }
+
+      if (strcmp (filename, "camera") == 0)
+        point->bg_type = PP_BG_CAMERA;
+      else if (str_has_video_suffix (filename))
+        point->bg_type = PP_BG_VIDEO;
+      else if (g_str_has_suffix (filename, ".svg"))
+        point->bg_type = PP_BG_SVG;
+      else if (pp_is_color (point->bg))
+        point->bg_type = PP_BG_COLOR;
+      else
+        point->bg_type = PP_BG_IMAGE;
+      g_free (filename);
+    }
+  pin_point_set_asset (point);
+
+  /* trim newlines from start and end. ' ' can be used in the insane case that
+   * you actually want blank lines before or after the text of a slide */
+  len = slide_str->len;
+  while (len && slide_str->str[len - 1] == '\n')
+    len--;
+  g_string_truncate (slide_str, len);
+  while (*str == '\n') str++;
+
+  point->text = g_string_chunk_insert (pp_strings, str);
+  if (notes_str->str[0])
+    point->speaker_notes = g_string_chunk_insert (pp_strings, notes_str->str);
+}
 
-  /* parse the slides, constructing lists of slide/point objects
-   */
-  for (p = slide_src; *p; p++)
+/* Parses the slides in src, adding their points to points without making
+ * them. When header is TRUE the text before the first separator is the
+ * presentation header and sets up default_point, otherwise it is skipped.
+ */
+static void
+pp_parse_points (const char *src,
+                 gboolean    header,
+                 GPtrArray  *points)
+{
+  const char    *p;
+  gboolean       done        = FALSE;
+  gboolean       startofline = TRUE;
+  gboolean       gotconfig   = !header;
+  GString       *slide_str   = g_string_new ("");
+  GString       *setting_str = g_string_new ("");
+  GString       *notes_str   = g_string_new ("");
+  gsize          len;
+  PinPointPoint *point       = NULL, *next_point;
+
+  if (header)
+    point = pin_point_new ();
+
+  for (p = src; *p; p++)
     {
       switch (*p)
         {
           case '\\': /* escape the next char */
-            p++;
             startofline = FALSE;
-            if (*p)
-              g_string_append_c (slide_str, *p);
+            if (p[1])
+              {
+                p++;
+                g_string_append_c (slide_str, *p);
+              }
             break;
           case '\n':
             startofline = TRUE;
@@ -793,14 +1954,15 @@ pp_parse_slides (PinPointRenderer *renderer,
             close_last_slide:
             if (startofline)
               {
-                next_point = pin_point_new (renderer);
+                const char *slide_start = p;
+
+                next_point = pin_point_new ();
+                next_point->source = slide_start;
 
                 g_string_assign (setting_str, "");
-                while (*p && *p!='\n')  /* until newline */
-                  {
-                    g_string_append_c (setting_str, *p);
-                    p++;
-                  }
+                len = strcspn (p, "\n");  /* until newline */
+                g_string_append_len (setting_str, p, len);
+                p += len;
                 parse_config (next_point, setting_str->str);
 
                 if (!gotconfig)
@@ -811,61 +1973,27 @@ pp_parse_slides (PinPointRenderer *renderer,
                     memcpy (point, &default_point,
                             sizeof (PinPointPoint) - sizeof (void *));
                     parse_config (point, setting_str->str);
+                    point->source = slide_start;
+                    g_free (next_point);
                     gotconfig = TRUE;
-                    g_string_assign (slide_str, "");
-                    g_string_assign (setting_str, "");
-                    g_string_assign (notes_str, "");
                   }
                 else
                   {
-                    if (point->bg && point->bg[0])
+                    if (point)
                       {
-                        char *filename = g_strdup (point->bg);
-                        int i = 0;
-
-                        while (filename[i])
-                          {
-                            filename[i] = tolower(filename[i]);
-                            i++;
-                          }
-
-                        if (strcmp (filename, "camera") == 0)
-                          point->bg_type = PP_BG_CAMERA;
-                        else if (str_has_video_suffix (filename))
-                          point->bg_type = PP_BG_VIDEO;
-                        else if (g_str_has_suffix (filename, ".svg"))
-                          point->bg_type = PP_BG_SVG;
-                        else if (pp_is_color (point->bg))
-                          point->bg_type = PP_BG_COLOR;
-                        else
-                          point->bg_type = PP_BG_IMAGE;
-                        g_free (filename);
+                        pin_point_finish (point, slide_str, notes_str);
+                        point->source_len = slide_start - point->source;
+                        g_ptr_array_add (points, point);
                       }
-
-                    {
-                      char *str = slide_str->str;
-
-                    /* trim newlines from start and end. ' ' can be used in the
-                     * insane case that you actually want blank lines before or
-                     * after the text of a slide */
-                      while (*str == '\n') str++;
-                      while ( slide_str->str[strlen(slide_str->str)-1]=='\n')
-                        slide_str->str[strlen(slide_str->str)-1]='\0';
-
-                      point->text = g_intern_string (str);
-                    }
-                    if (notes_str->str[0])
-                      point->speaker_notes = g_strdup (notes_str->str);
-
-                    renderer->make_point (renderer, point);
-
-                    g_string_assign (slide_str, "");
-                    g_string_assign (setting_str, "");
-                    g_string_assign (notes_str, "");
-
-                    pp_slides = g_list_append (pp_slides, point);
                     point = next_point;
                   }
+
+                g_string_assign (slide_str, "");
+                g_string_assign (setting_str, "");
+                g_string_assign (notes_str, "");
+
+                if (!*p) /* the separator was the last line */
+                  p--;
               }
             else
               {
@@ -875,39 +2003,316 @@ pp_parse_slides (PinPointRenderer *renderer,
         case '#': /* comment */
           if (startofline)
             {
-              const char *end = p + 1;
-              while (*end != '\n' && *end != '\0')
-                {
-                  g_string_append_c (notes_str, *end);
-                  end++;
-                }
-              if (end)
-                {
-                  g_string_append_c (notes_str, '\n');
-                  p = end;
-                  break;
-                }
+              const char *end = p + 1 + strcspn (p + 1, "\n");
+
+              g_string_append_len (notes_str, p + 1, end - (p + 1));
+              g_string_append_c (notes_str, '\n');
+              p = *end ? end : end - 1;
+              break;
             }
           /* flow through */
           default:
+            /* nothing is special again until the end of the line or the
+             * next escape, so copy up to there at once */
             startofline = FALSE;
-            g_string_append_c (slide_str, *p);
+            len = strcspn (p, "\\\n");
+            g_string_append_len (slide_str, p, len);
+            p += len - 1;
             break;
         }
+
+      if (done) /* the last slide was closed at the terminating '\0' */
+        break;
     }
 
   if (!done)
     {
       done = TRUE;
+      startofline = TRUE;
       goto close_last_slide;
     }
 
+  g_free (point); /* opened by the last separator, never made */
   g_string_free (slide_str, TRUE);
   g_string_free (setting_str, TRUE);
   g_string_free (notes_str, TRUE);
+}
 
-  if (g_list_nth (pp_slides, slideno))
-    pp_slidep = g_list_nth (pp_slides, slideno);
+void
+pp_parse_slides (PinPointRenderer *renderer,
+                 const char       *slide_src)
+{
+  int         slideno     = 0;
+  guint       i;
+  char       *old_source  = renderer->source;
+  GPtrArray  *old_slides  = pp_slides;
+  GHashTable *old_points  = NULL;
+  gsize       old_header  = 0;
+  GStringChunk *old_strings = pp_strings;
+  GPtrArray  *points;
+  int         rebuilt     = 0;
+  gboolean    cached      = FALSE;
+  GTimer     *timer       = g_timer_new ();
+
+  slideno = pp_slideno;
+  pp_renderer = renderer;
+
+  /* start over from the built-in defaults, the header of the presentation is
+   * applied again below */
+  pp_strings = g_string_chunk_new (strlen (slide_src) + 1);
+  default_point = pin_default_point;
+
+  /* the points keep pointing into our own copy of the source */
+  renderer->source = g_strdup (slide_src);
+  slide_src = renderer->source;
+
+  if (old_slides && old_slides->len)
+    {
+      PinPointPoint *first = g_ptr_array_index (old_slides, 0);
+
+      old_header = first->source - old_source;
+      old_points = pin_point_table_new (old_slides);
+    }
+
+  pp_slides = g_ptr_array_sized_new (old_slides ? old_slides->len : 64);
+
+  /* reloads only rebuild what changed, the cache is for starting up */
+  if (!old_slides && pp_cache_load (slide_src))
+    {
+      rebuilt = pp_slides->len;
+      cached = TRUE;
+      goto parsed;
+    }
+
+  points = g_ptr_array_sized_new (pp_slides->len);
+  pp_parse_points (slide_src, TRUE, points);
+
+  /* slides can only be kept when the defaults they were built with did not
+   * change */
+  if (old_points && points->len)
+    {
+      PinPointPoint *first = g_ptr_array_index (points, 0);
+
+      if (first->source - slide_src != old_header ||
+          memcmp (slide_src, old_source, old_header))
+        {
+          pin_point_table_free (renderer, old_points);
+          old_points = NULL;
+        }
+    }
+
+  for (i = 0; i < points->len; i++)
+    {
+      PinPointPoint *point = g_ptr_array_index (points, i);
+      PinPointPoint *old   = NULL;
+
+      if (old_points)
+        old = pin_point_table_take (old_points, point);
+
+      if (old)
+        {
+          pin_point_update (old, point);
+          pin_point_free (renderer, point);
+          point = old;
+        }
+      else
+        {
+          rebuilt++;
+        }
+
+      g_ptr_array_add (pp_slides, point);
+    }
+  g_ptr_array_free (points, TRUE);
+
+  pp_cache_save (slide_src);
+
+parsed:
+  /* go to the first slide that changed, or stay where we were */
+  for (i = 0;
+       old_slides && i < pp_slides->len && i < old_slides->len &&
+       g_ptr_array_index (pp_slides, i) == g_ptr_array_index (old_slides, i);
+       i++);
+  if (i < pp_slides->len)
+    slideno = i;
+  else if (old_slides && i < old_slides->len)
+    slideno = pp_slides->len - 1;
+
+  /* whatever was not taken over by the new parse goes */
+  if (old_points)
+    pin_point_table_free (renderer, old_points);
+  if (old_slides)
+    g_ptr_array_free (old_slides, TRUE);
+  g_free (old_source);
+  if (old_strings)
+    g_string_chunk_free (old_strings);
+  pp_assets_sweep (renderer);
+
+  g_debug ("parsed %u slides%s in %.2fms, %d of them new",
+           pp_slides->len, cached ? " from the cache" : "",
+           g_timer_elapsed (timer, NULL) * 1000.0, rebuilt);
+  g_timer_destroy (timer);
+
+  pp_timing_rebuild ();
+
+  if (slideno >= 0 && slideno < (gint) pp_slides->len)
+    pp_slideno = slideno;
+  else
+    pp_slideno = pp_slides->len ? 0 : -1;
+
+  pp_slides_window_update ();
+}
+
+/*
+ * Streaming
+ *
+ * With --stream the presentation is read as it is being written. A slide is
+ * complete once the separator of the next one has arrived, or the stream has
+ * ended. Only then it is parsed, made and appended, and the slides before it
+ * are left alone.
+ */
+
+static GString *pp_stream_pending = NULL; /* text not parsed yet */
+static gboolean pp_stream_header  = TRUE; /* the header is still to come */
+static guint    pp_stream_dropped = 0;    /* slides dropped since the strings
+                                             were last compacted */
+
+/* length of the text before its last slide separator */
+static gsize
+pp_stream_complete (const char *text,
+                    gsize       len)
+{
+  gsize i;
+
+  for (i = len - 1; i > 0; i--)
+    {
+      gsize escapes = 0;
+
+      if (text[i] != '-' || text[i - 1] != '\n')
+        continue;
+
+      /* a newline escaped with a backslash does not start a line */
+      while (escapes < i - 1 && text[i - 2 - escapes] == '\\')
+        escapes++;
+      if (escapes % 2 == 0)
+        return i;
+    }
+  return 0;
+}
+
+/* Move the strings of the remaining points to a new chunk, leaving those of
+ * dropped slides behind. The built-in defaults are not copied.
+ */
+static void
+pp_strings_compact (void)
+{
+  GStringChunk *strings = g_string_chunk_new (4096);
+  guint         i, j;
+
+  for (i = 0; i <= pp_slide_count (); i++)
+    {
+      PinPointPoint *point = i ? pp_slide_nth (i - 1) : &default_point;
+
+      for (j = 0; j < G_N_ELEMENTS (pp_cache_strings); j++)
+        if (POINT_STRING (point, j) &&
+            POINT_STRING (point, j) != POINT_STRING (&pin_default_point, j))
+          POINT_STRING (point, j) =
+            g_string_chunk_insert_const (strings, POINT_STRING (point, j));
+
+      if (point->source)
+        point->source = g_string_chunk_insert_len (strings, point->source,
+                                                   point->source_len);
+    }
+
+  g_string_chunk_free (pp_strings);
+  pp_strings = strings;
+}
+
+/* Drop the oldest slides beyond --stream-keep. The window before the shown
+ * slide is kept, and so is everything from the first slide that is still
+ * animating, like the one just left.
+ */
+static void
+pp_stream_drop (PinPointRenderer *renderer)
+{
+  guint n, i;
+
+  if (pp_stream_keep <= 0 || pp_slide_count () <= (guint) pp_stream_keep)
+    return;
+
+  n = MIN (pp_slide_count () - pp_stream_keep,
+           (guint) MAX (pp_slideno - pp_window_before, 0));
+  for (i = 0; i < n; i++)
+    if (pp_slide_nth (i)->animating)
+      n = i;
+  if (!n)
+    return;
+
+  for (i = 0; i < n; i++)
+    pin_point_free (renderer, pp_slide_nth (i));
+  g_ptr_array_remove_range (pp_slides, 0, n);
+  pp_slideno -= n;
+  pp_timing_rebuild ();
+  if (renderer->slides_dropped)
+    renderer->slides_dropped (renderer, n);
+  pp_assets_sweep (renderer);
+
+  /* compacting costs about as much as the slides that are left, do it once
+   * as many have been dropped */
+  pp_stream_dropped += n;
+  if (pp_stream_dropped >= pp_slide_count ())
+    {
+      pp_strings_compact ();
+      pp_stream_dropped = 0;
+    }
+}
+
+/* Feed the next len bytes of the stream, eof tells that no more will come.
+ * Returns the number of slides appended.
+ */
+guint
+pp_stream_append (PinPointRenderer *renderer,
+                  const char       *text,
+                  gsize             len,
+                  gboolean          eof)
+{
+  GPtrArray *points;
+  gsize      complete;
+  char      *chunk;
+  guint      i, added;
+
+  if (!pp_stream_pending)
+    pp_stream_pending = g_string_new ("");
+  g_string_append_len (pp_stream_pending, text, len);
+
+  if (eof)
+    complete = pp_stream_pending->len;
+  else if (pp_stream_pending->len)
+    complete = pp_stream_complete (pp_stream_pending->str,
+                                   pp_stream_pending->len);
   else
-    pp_slidep = pp_slides;
+    complete = 0;
+  if (!complete)
+    return 0;
+
+  /* the points point into the text of their slides */
+  chunk = g_string_chunk_insert_len (pp_strings, pp_stream_pending->str,
+                                     complete);
+  g_string_erase (pp_stream_pending, 0, complete);
+
+  points = g_ptr_array_new ();
+  pp_parse_points (chunk, pp_stream_header, points);
+  pp_stream_header = FALSE;
+
+  for (i = 0; i < points->len; i++)
+    g_ptr_array_add (pp_slides, g_ptr_array_index (points, i));
+  added = points->len;
+  g_ptr_array_free (points, TRUE);
+
+  pp_timing_extend ();
+  pp_stream_drop (renderer);
+  pp_slides_window_update ();
+
+  g_debug ("streamed %u slides, %u in the presentation",
+           added, pp_slide_count ());
+  return added;
 }
@@ -32,6 +32,7 @@
 
 typedef struct _PinPointPoint    PinPointPoint;
 typedef struct _PinPointRenderer PinPointRenderer;
+typedef struct _PinPointAsset    PinPointAsset;
 
 typedef enum
 {
@@ -76,9 +77,32 @@ struct _PinPointRenderer
   void *    (*allocate_data) (PinPointRenderer *renderer);
   void      (*free_data)     (PinPointRenderer *renderer,
                               void             *datap);
+  /* the first n slides were dropped and the others moved down by n, for
+   * renderers keeping state by slide number; may be NULL */
+  void      (*slides_dropped) (PinPointRenderer *renderer,
+                               guint             n);
+  /* let go of what is kept for the assets no slide uses any more, those
+   * with used unset, see pp_assets_sweep (); may be NULL */
+  void      (*release_assets) (PinPointRenderer *renderer);
   char *      source;
 };
 
+/* A background file, shared by all the slides using it however they name
+ * it. Renderers keying caches on an asset hold a reference to it, see
+ * pp_asset_ref (); the slides do not. An asset goes once no slide uses it
+ * and nothing references it.
+ */
+struct _PinPointAsset
+{
+  char     *path;     /* full path of the file */
+  gint      width;    /* see pp_asset_get_size () */
+  gint      height;
+  gboolean  probed;
+  gint64    mtime;    /* of the file when it was probed, -1 if unknown */
+  gint      refs;     /* atomic */
+  gboolean  used;     /* by a slide, as of the last sweep */
+};
+
 struct _PinPointPoint
 {
   const char        *stage_color;
@@ -86,6 +110,7 @@ struct _PinPointPoint
   const gchar       *bg;
   PPBackgroundType   bg_type;
   PPBackgroundScale  bg_scale;
+  PinPointAsset     *asset;           /* for image, video and svg backgrounds */
 
   const char        *text;            /*  the text of the slide */
   ClutterGravity     position;
@@ -110,9 +135,20 @@ struct _PinPointPoint
 
   const char        *command;
 
+  gfloat             video_start;     /* seconds into a video background to
+                                         start playing it at */
+
   gint              camera_framerate;
   PPResolution      camera_resolution;
 
+  const char        *source;          /* start of this slide in the renderer's
+                                         source, from its separator line up to
+                                         the next one */
+  gsize              source_len;
+
+  gboolean           ready;           /* make_point () has been run */
+  gboolean           animating;       /* see pp_slide_set_animating () */
+
   void              *data;            /* the renderer can attach data here */
 };
 
@@ -121,15 +157,43 @@ extern gboolean  pp_fullscreen;
 extern gboolean  pp_maximized;
 extern gboolean  pp_speakermode;
 extern gboolean  pp_rehearse;
+extern gboolean  pp_stats;
 extern char     *pp_camera_device;
-
-extern GList         *pp_slides;  /* list of slide text */
-extern GList         *pp_slidep;  /* current slide */
+extern gboolean  pp_stream;
+extern gint      pp_stream_keep;
+extern gint      pp_window_before;
+extern gint      pp_window_after;
+extern gint      pp_max_made;
+extern gint      pp_texture_budget;
+
+extern GPtrArray     *pp_slides;  /* the slides, in presentation order */
+extern gint           pp_slideno; /* index of the current slide, -1 if none */
 extern GFile         *pp_basedir;
 extern PinPointPoint *point_defaults;
 
 void     pp_parse_slides  (PinPointRenderer *renderer,
                            const char       *slide_src);
+guint    pp_stream_append (PinPointRenderer *renderer,
+                           const char       *text,
+                           gsize             len,
+                           gboolean          eof);
+
+PinPointAsset *pp_asset_lookup   (const char    *name);
+PinPointAsset *pp_asset_ref      (PinPointAsset *asset);
+void           pp_asset_unref    (PinPointAsset *asset);
+gboolean       pp_asset_get_size (PinPointAsset *asset,
+                                  gint          *width,
+                                  gint          *height);
+
+guint          pp_slide_count   (void);
+PinPointPoint *pp_slide_nth     (gint n);
+PinPointPoint *pp_slide_ready   (gint n);
+PinPointPoint *pp_slide_current (void);
+gint           pp_slide_index   (PinPointPoint *point);
+void           pp_slide_set_animating  (PinPointPoint *point,
+                                        gboolean       animating);
+GList         *pp_slides_animating     (void);
+void           pp_slides_window_update (void);
 
 void
 pp_get_padding (float  stage_width,
@@ -138,6 +202,12 @@ pp_get_padding (float  stage_width,
 
 void pp_rehearse_init (void);
 void pp_rehearse_done (void);
+void pp_rehearse_add  (gint   slideno,
+                       gfloat seconds);
+
+void   pp_timing_rebuild (void);
+gfloat pp_slides_time    (gint start,
+                          gint end);
 
 void
 pp_get_background_position_scale (PinPointPoint *point,
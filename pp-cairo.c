@@ -38,6 +38,8 @@
 
 #define CAIRO_RENDERER(renderer)  ((CairoRenderer *) renderer)
 
+#define VIDEO_THUMB_THREADS 3 /* videos thumbnailed at the same time */
+
 typedef struct _CairoRenderer
 {
   PinPointRenderer renderer;
@@ -45,11 +47,14 @@ typedef struct _CairoRenderer
   GHashTable      *surfaces;    /* keep cairo_surface_t around for source
                                    images as we want to only include one
                                    instance of the image when using it in
-                                   several slides */
+                                   several slides, keyed by PinPointAsset */
   GHashTable      *svgs;        /* keep RsvgHandles around for source
                                    svg backgrounds as we want to only
                                    include one instance of the image
                                    when using it in several slides */
+#ifdef USE_CLUTTER_GST
+  GstVideoThumbnailer *thumbnailer; /* shots of the video backgrounds */
+#endif
   cairo_surface_t *surface;
   cairo_t         *ctx;
   double           width;
@@ -87,11 +92,15 @@ cairo_renderer_init (PinPointRenderer *pp_renderer,
   renderer->path = g_strdup (pinpoint_file);
 
   renderer->ctx = cairo_create (renderer->surface);
-  renderer->surfaces = g_hash_table_new_full (g_str_hash, g_str_equal,
-                                              g_free, _destroy_surface);
-  renderer->svgs = g_hash_table_new_full (g_str_hash, g_str_equal,
-                                          NULL,
+  renderer->surfaces = g_hash_table_new_full (NULL, NULL,
+                                              (GDestroyNotify) pp_asset_unref,
+                                              _destroy_surface);
+  renderer->svgs = g_hash_table_new_full (NULL, NULL,
+                                          (GDestroyNotify) pp_asset_unref,
                                           g_object_unref);
+#ifdef USE_CLUTTER_GST
+  renderer->thumbnailer = gst_video_thumbnailer_new (VIDEO_THUMB_THREADS);
+#endif
 }
 
 /* This function is adapted from Gtk's gdk_cairo_set_source_pixbuf() you can
@@ -211,13 +220,14 @@ _cairo_read_file (const char     *file,
 
 static cairo_surface_t *
 _cairo_get_surface (CairoRenderer *renderer,
-                    const char    *file)
+                    PinPointAsset *asset)
 {
   cairo_surface_t *surface;
   GdkPixbuf       *pixbuf;
   GError          *error = NULL;
+  const char      *file = asset->path;
 
-  surface = g_hash_table_lookup (renderer->surfaces, file);
+  surface = g_hash_table_lookup (renderer->surfaces, asset);
   if (surface)
     return surface;
 
@@ -233,7 +243,8 @@ _cairo_get_surface (CairoRenderer *renderer,
     }
 
   surface = _cairo_new_surface_from_pixbuf (pixbuf);
-  g_hash_table_insert (renderer->surfaces, g_strdup (file), surface);
+  g_object_unref (pixbuf);
+  g_hash_table_insert (renderer->surfaces, pp_asset_ref (asset), surface);
 
   /* If we embed a JPEG, we can actually insert the coded data into the PDF in
    * a lossless fashion (no recompression of the JPEG) */
@@ -255,28 +266,29 @@ _cairo_get_surface (CairoRenderer *renderer,
 
 static RsvgHandle *
 _cairo_get_svg (CairoRenderer *renderer,
-                const char    *file)
+                PinPointAsset *asset)
 {
   RsvgHandle *svg;
   GError     *error = NULL;
 
-  svg = g_hash_table_lookup (renderer->svgs, file);
+  svg = g_hash_table_lookup (renderer->svgs, asset);
   if (svg)
     return svg;
 
-  svg = rsvg_handle_new_from_file (file, &error);
+  svg = rsvg_handle_new_from_file (asset->path, &error);
 
   if (svg == NULL)
     {
       if (error)
         {
-          g_warning ("could not load file %s: %s", file, error->message);
+          g_warning ("could not load file %s: %s", asset->path,
+                     error->message);
           g_clear_error (&error);
         }
       return NULL;
     }
 
-  g_hash_table_insert (renderer->svgs, (char *) file, svg);
+  g_hash_table_insert (renderer->svgs, pp_asset_ref (asset), svg);
 
   return svg;
 }
@@ -287,23 +299,9 @@ static void
 _cairo_render_background (CairoRenderer *renderer,
                           PinPointPoint *point)
 {
-  char       *full_path = NULL;
-  const char *file;
-
   if (point == NULL || point->bg == NULL)
     return;
 
-  file = point->bg;
-
-  if (point->bg_type != PP_BG_COLOR && renderer->path && file)
-    {
-      char *dir = g_path_get_dirname (renderer->path);
-      full_path = g_build_filename (dir, file, NULL);
-      g_free (dir);
-
-      file = full_path;
-    }
-
   if (point->stage_color)
     {
       ClutterColor color;
@@ -337,7 +335,7 @@ _cairo_render_background (CairoRenderer *renderer,
         cairo_surface_t *surface;
         float bg_x, bg_y, bg_width, bg_height, bg_scale_x, bg_scale_y;
 
-        surface = _cairo_get_surface (renderer, file);
+        surface = _cairo_get_surface (renderer, point->asset);
         if (surface == NULL)
           break;
 
@@ -362,28 +360,26 @@ _cairo_render_background (CairoRenderer *renderer,
     case PP_BG_VIDEO:
       {
 #ifdef USE_CLUTTER_GST
-        GdkPixbuf       *pixbuf;
         cairo_surface_t *surface;
         float bg_x, bg_y, bg_width, bg_height, bg_scale_x, bg_scale_y;
-        GCancellable* cancellable = g_cancellable_new ();
-        GFile *abs_file;
-        gchar *abs_path;
-
-        abs_file = g_file_resolve_relative_path (pp_basedir, point->bg);
-        abs_path = g_file_get_path (abs_file);
-        g_object_unref (abs_file);
 
-        pixbuf = gst_video_thumbnailer_get_shot (abs_path, cancellable);
-        g_free (abs_path);
-        if (pixbuf == NULL)
+        /* thumbnailing a video is costly, do it once per video */
+        surface = g_hash_table_lookup (renderer->surfaces, point->asset);
+        if (surface == NULL)
           {
-            g_warning ("Could not create video thumbmail for %s", point->bg);
-            break;
+            surface = gst_video_thumbnailer_get_shot (renderer->thumbnailer,
+                                                      point->asset->path);
+            if (surface == NULL)
+              {
+                g_warning ("Could not create video thumbmail for %s",
+                           point->bg);
+                break;
+              }
+
+            g_hash_table_insert (renderer->surfaces,
+                                 pp_asset_ref (point->asset), surface);
           }
 
-        surface = _cairo_new_surface_from_pixbuf (pixbuf);
-        g_hash_table_insert (renderer->surfaces, g_strdup (file), surface);
-
         bg_width = cairo_image_surface_get_width (surface);
         bg_height = cairo_image_surface_get_height (surface);
 
@@ -405,7 +401,7 @@ _cairo_render_background (CairoRenderer *renderer,
     case PP_BG_SVG:
 #ifdef HAVE_RSVG
       {
-        RsvgHandle *svg = _cairo_get_svg (renderer, file);
+        RsvgHandle *svg = _cairo_get_svg (renderer, point->asset);
         RsvgDimensionData dim;
         float bg_x, bg_y, bg_scale_x, bg_scale_y;
 
@@ -435,8 +431,6 @@ _cairo_render_background (CairoRenderer *renderer,
     default:
       g_assert_not_reached();
     }
-
-  g_free (full_path);
 }
 
 static void
@@ -559,11 +553,24 @@ static void
 cairo_renderer_run (PinPointRenderer *pp_renderer)
 {
   CairoRenderer *renderer = CAIRO_RENDERER (pp_renderer);
-  GList         *cur;
+  guint          i;
+
+#ifdef USE_CLUTTER_GST
+  /* have the videos thumbnailed in the background while the pages before
+   * them are rendered */
+  for (i = 0; i < pp_slide_count (); i++)
+    {
+      PinPointPoint *point = pp_slide_nth (i);
+
+      if (point->bg_type == PP_BG_VIDEO && point->asset)
+        gst_video_thumbnailer_queue (renderer->thumbnailer,
+                                     point->asset->path);
+    }
+#endif
 
-  for (cur = pp_slides; cur; cur = g_list_next (cur))
+  for (i = 0; i < pp_slide_count (); i++)
     {
-      PinPointPoint *point = cur->data;
+      PinPointPoint *point = pp_slide_ready (i);
 
       cairo_renderer_render_page (renderer, point);
       if (point->speaker_notes)
@@ -581,6 +588,9 @@ cairo_renderer_finalize (PinPointRenderer *pp_renderer)
     cairo_surface_destroy (renderer->surface);
   g_hash_table_unref (renderer->surfaces);
   g_hash_table_unref (renderer->svgs);
+#ifdef USE_CLUTTER_GST
+  gst_video_thumbnailer_free (renderer->thumbnailer);
+#endif
   if (renderer->ctx)
     cairo_destroy (renderer->ctx);
 }
@@ -643,6 +653,24 @@ cairo_renderer_free_data (PinPointRenderer *renderer,
 {
 }
 
+static gboolean
+asset_unused (gpointer key,
+              gpointer value,
+              gpointer user_data)
+{
+  return !((PinPointAsset *) key)->used;
+}
+
+/* when previewing, called with the preview lock held */
+static void
+cairo_renderer_release_assets (PinPointRenderer *pp_renderer)
+{
+  CairoRenderer *renderer = CAIRO_RENDERER (pp_renderer);
+
+  g_hash_table_foreach_remove (renderer->surfaces, asset_unused, NULL);
+  g_hash_table_foreach_remove (renderer->svgs, asset_unused, NULL);
+}
+
 static CairoRenderer cairo_renderer_vtable =
 {
   .renderer =
@@ -652,7 +680,8 @@ static CairoRenderer cairo_renderer_vtable =
       .finalize = cairo_renderer_finalize,
       .make_point = cairo_renderer_make_point,
       .allocate_data = cairo_renderer_allocate_data,
-      .free_data = cairo_renderer_free_data
+      .free_data = cairo_renderer_free_data,
+      .release_assets = cairo_renderer_release_assets
     }
 };
 
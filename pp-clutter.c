@@ -31,6 +31,8 @@
 #include <clutter/x11/clutter-x11.h>
 #endif
 #include <gio/gio.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
+#include <glib/gstdio.h>
 #ifdef USE_CLUTTER_GST
 #include <clutter-gst/clutter-gst.h>
 #endif
@@ -42,6 +44,8 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include <unistd.h>
 
 void cairo_renderer_unset_cr (PinPointRenderer *pp_renderer);
 
@@ -60,6 +64,7 @@ void cairo_renderer_render_page (void          *renderer,
 #define RESTDEPTH   -9000.0
 #define RESTX        4600.0
 #define STARTPOS    -3000.0
+#define RESTSTEP      200.0 /* between the texts of consecutive slides */
 
 /* The maximum of these is used, either 80% of the slide time
    or 20seconds left of the slide
@@ -73,6 +78,17 @@ void cairo_renderer_render_page (void          *renderer,
 #define PREVIEW_WIDTH  640
 #define PREVIEW_HEIGHT 480
 
+/* parts of the speaker screen to update */
+enum
+{
+  SPEAKER_TIME   = 1 << 0, /* clock, time progress and overtime warning */
+  SPEAKER_LAYOUT = 1 << 1, /* positions and sizes */
+  SPEAKER_SLIDE  = 1 << 2, /* previews, notes and slide progress */
+  SPEAKER_ALL    = SPEAKER_TIME | SPEAKER_LAYOUT | SPEAKER_SLIDE
+};
+
+#define DECODE_THREADS 2
+
 static ClutterColor c_prog_bg =    {0x11,0x11,0x11,0xff};
 static ClutterColor c_prog_slide = {0xff,0xff,0xff,0x77};
 static ClutterColor c_prog_time =  {0xff,0xff,0xff,0x55};
@@ -98,7 +114,30 @@ typedef enum _PPClutterBackend
 typedef struct _ClutterRenderer
 {
   PinPointRenderer renderer;
-  GHashTable      *bg_cache;    /* only load the same backgrounds once */
+  GHashTable      *bg_cache;    /* only load the same backgrounds once,
+                                   keyed by PinPointAsset, see
+                                   texture_cache_trim () */
+  GHashTable      *decode_jobs; /* PinPointAsset -> DecodeJob */
+  GThreadPool     *decode_pool; /* decodes background images */
+  gint             decode_current; /* slide the pool sorts around */
+  gint             decode_shown; /* last slide counted as hit or miss */
+  guint            decode_hits;  /* background was ready when shown */
+  guint            decode_misses;
+  gsize            texture_bytes;      /* uploaded background pixels */
+  gsize            texture_bytes_full; /* same, at full source size */
+  guint            texture_clock;      /* for the LRU stamps of DecodeJob */
+#ifdef USE_CLUTTER_GST
+  GHashTable      *videos;      /* PinPointAsset -> VideoPipe */
+  guint            video_clock; /* bumped by each video_prefetch () */
+  struct _VideoPipe *video_waiting; /* shown, its first frame not yet */
+  guint            video_frame_id;  /* repaint func, see video_frame_ready () */
+  guint            video_starts;    /* first frames, and their latency from */
+  gint64           video_start_total; /* slide_requested, in µs */
+  gint64           video_start_max;
+#endif
+  gint64           input_time;      /* of the last key press or click */
+  gint64           slide_requested; /* input_time of the slide shown, or the
+                                       time show_slide () ran */
   ClutterActor    *stage;
   ClutterActor    *root;
 
@@ -108,6 +147,8 @@ typedef struct _ClutterRenderer
   ClutterActor    *foreground;
 
   ClutterActor    *json_layer;
+  GHashTable      *transitions;     /* name -> GBytes of the JSON, or NULL */
+  GHashTable      *transition_pool; /* name -> GQueue of TransitionInstance */
   ClutterActor    *curtain;
 
   ClutterActor    *commandline;
@@ -148,14 +189,53 @@ typedef struct _ClutterRenderer
   ClutterActor    *speaker_time_remaining;
 
   char *path;               /* path of the file of the GFileMonitor callback */
-  float rest_y;             /* where the text can rest */
 
-  gboolean reset;           /* tells the speaker screen update function to
-                               reset all state
-                             */
+  guint speaker_dirty;      /* SPEAKER_* parts of the speaker screen to
+                               update, see speaker_screen_queue () */
+  guint speaker_idle;       /* idle updating the speaker screen */
+  guint speaker_tick;       /* 1 Hz timeout for the clock */
+
+  gdouble slide_duration;   /* time allotted to the current slide */
+  guint   autoadvance_id;   /* fires when the current slide's time is up */
+
+  gint jump_to;             /* slide number typed so far, jumped to on Enter,
+                               -1 while none is being typed */
+
+  guint relayout_id;        /* repaint function coalescing stage resizes */
+
+  gulong        stats_id;          /* paint handler timing the frames */
+  gint64        stats_last;        /* when the last frame was painted */
+  gdouble       stats_frame_ms;    /* the stage's frame interval */
+  GHashTable   *stats_slides;      /* checksum of the slide's source ->
+                                      FrameStats, see stats_slide_get () */
+  PinPointPoint *stats_point;      /* the slide stats_current is of */
+  const char   *stats_source;      /* and its source then */
+  struct _FrameStats *stats_current;
+  GHashTable   *stats_transitions; /* interned name -> FrameStats */
+  ClutterActor *stats_overlay;
+  guint         stats_overlay_id;  /* refreshes the overlay */
+  GSource      *stats_wakeups;     /* a WakeupCounter */
+  gint64        stats_start;       /* when the statistics started */
+  clock_t       stats_cpu_start;
+  guint         stats_wakeups_seen; /* counts at the last overlay refresh */
+  gint64        stats_wakeups_time;
 
   PinPointRenderer *cairo_renderer;
 
+  GMutex            cairo_lock;      /* cairo_renderer is not reentrant */
+  GThreadPool      *preview_pool;    /* renders with cairo_renderer */
+  GHashTable       *previews;        /* key -> rendered cairo_surface_t */
+  GQueue           *preview_order;   /* keys of previews, oldest first */
+  GHashTable       *preview_pending; /* keys being rendered */
+  gint              preview_current; /* slide on the speaker screen, the
+                                        workers skip those far from it */
+
+  ClutterActor     *overview;        /* the slide grid, when shown */
+  GPtrArray        *overview_thumbs; /* its cells, by slide number */
+  gint              overview_generation; /* bumped when it closes, atomic */
+  GThreadPool      *thumb_pool;      /* loads and renders the thumbnails */
+  char             *thumb_dir;       /* where thumbnails are kept */
+
   /* Proxy object for the Gnome Session Manager; used to inhibit suspend during
    * presentations.
    */
@@ -178,25 +258,40 @@ typedef struct
 
   ClutterState     *state;
   ClutterActor     *json_slide;
+  const char       *transition; /* interned name of the json_slide's template */
   ClutterActor     *background2;
   ClutterScript    *script;
   ClutterActor     *midground;
   ClutterActor     *foreground;
   ClutterActor     *shading;
+  guint             animation_id; /* ends the slide's animation, see
+                                     slide_animation_start () */
 
 #ifdef USE_CLUTTER_GST
   GstElement       *pipeline; /* used for the custom camera pipeline */
+  struct _VideoPipe *video;   /* shared pipeline of video backgrounds */
 #endif
 } ClutterPointData;
 
 #define CLUTTER_RENDERER(renderer)  ((ClutterRenderer *) renderer)
 
 
+static void     decode_run     (gpointer          data,
+                                gpointer          user_data);
+static void     preview_run    (gpointer          data,
+                                gpointer          user_data);
+static gint     decode_compare (gconstpointer     a,
+                                gconstpointer     b,
+                                gpointer          user_data);
+static void     transition_release (ClutterRenderer  *renderer,
+                                    ClutterPointData *data);
 static void     leave_slide   (ClutterRenderer  *renderer,
                                gboolean          backwards);
 static void     show_slide    (ClutterRenderer  *renderer,
                                gboolean          backwards);
 static void     action_slide  (ClutterRenderer  *renderer);
+static void     overview_toggle (ClutterRenderer *renderer);
+static void     overview_update (ClutterRenderer *renderer);
 static void     activate_commandline   (ClutterRenderer  *renderer);
 static void     file_changed  (GFileMonitor     *monitor,
                                GFile            *file,
@@ -212,6 +307,9 @@ static gboolean key_pressed (ClutterActor    *actor,
 static gboolean mouse_clicked  (ClutterActor    *actor,
                                 ClutterEvent    *event,
                                 ClutterRenderer *renderer);
+static void     goto_slide    (ClutterRenderer  *renderer,
+                               gint              slideno);
+static void     stream_open   (ClutterRenderer  *renderer);
 
 static void
 pp_actor_animate (ClutterActor         *actor,
@@ -388,14 +486,6 @@ pp_get_fullscreen (ClutterRenderer *renderer,
     }
 }
 
-static void
-_destroy_surface (gpointer data)
-{
-  /* not destroying background, since it would be destroyed with
-   * the stage itself.
-   */
-}
-
 static guint hide_cursor = 0;
 static gboolean hide_cursor_cb (gpointer stage)
 {
@@ -411,11 +501,10 @@ activate_commandline (ClutterRenderer *renderer)
 {
   PinPointPoint *point;
 
-  if (!pp_slidep)
+  point = pp_slide_current ();
+  if (!point)
     return;
 
-  point = pp_slidep->data;
-
   pp_actor_animate (renderer->commandline, CLUTTER_LINEAR, 500,
                      "opacity", 0xff, NULL);
 
@@ -437,7 +526,7 @@ static gboolean commandline_cancel_cb (ClutterActor *actor,
                                        gpointer      data)
 {
   ClutterRenderer *renderer = CLUTTER_RENDERER (data);
-  PinPointPoint *point = pp_slidep->data;
+  PinPointPoint *point = pp_slide_current ();
 
   if (clutter_event_type (event) == CLUTTER_KEY_PRESS &&
       (clutter_event_get_key_symbol (event) == CLUTTER_Escape ||
@@ -461,7 +550,7 @@ static gboolean commandline_action_cb (ClutterActor *actor,
                                        gpointer      data)
 {
   ClutterRenderer *renderer = CLUTTER_RENDERER (data);
-  PinPointPoint *point = pp_slidep->data;
+  PinPointPoint *point = pp_slide_current ();
   clutter_actor_grab_key_focus (renderer->stage);
   pp_actor_animate (renderer->commandline,
                     CLUTTER_LINEAR, 500,
@@ -514,12 +603,7 @@ static gboolean stage_motion (ClutterActor *actor,
     {
       float d = event->motion.x / stage_width;
 #endif
-      if (pp_slidep)
-        {
-          leave_slide (renderer, FALSE);
-        }
-      pp_slidep = g_list_nth (pp_slides, g_list_length (pp_slides) * d);
-      show_slide (renderer, FALSE);
+      goto_slide (renderer, pp_slide_count () * d);
     }
 
   return FALSE;
@@ -559,6 +643,8 @@ opacity_hover_leave (ClutterActor *actor,
       g_signal_connect (o, "leave-event",            \
                         G_CALLBACK (opacity_hover_leave), NULL); \
 
+static void     autoadvance_schedule (ClutterRenderer *renderer);
+
 static gboolean
 play_pause (ClutterActor *actor,
             ClutterEvent *event,
@@ -580,6 +666,7 @@ play_pause (ClutterActor *actor,
       renderer->timer_paused = TRUE;
       clutter_text_set_text (CLUTTER_TEXT (renderer->speaker_pause), "Go");
     }
+  autoadvance_schedule (renderer);
   return TRUE;
 }
 
@@ -601,6 +688,7 @@ toggle_autoadvance (ClutterActor *actor,
       clutter_text_set_text (CLUTTER_TEXT (renderer->speaker_autoadvance),
                              "disable autoadvance");
     }
+  autoadvance_schedule (renderer);
   return TRUE;
 }
 
@@ -609,10 +697,10 @@ static void end_of_presentation (ClutterRenderer *renderer);
 static void
 next_slide (ClutterRenderer *renderer)
 {
-  if (pp_slidep && pp_slidep->next)
+  if (pp_slide_current () && pp_slide_nth (pp_slideno + 1))
     {
       leave_slide (renderer, FALSE);
-      pp_slidep = pp_slidep->next;
+      pp_slideno++;
       show_slide (renderer, FALSE);
     }
   else
@@ -624,14 +712,29 @@ next_slide (ClutterRenderer *renderer)
 static void
 prev_slide (ClutterRenderer *renderer)
 {
-  if (pp_slidep && pp_slidep->prev)
+  if (pp_slide_current () && pp_slide_nth (pp_slideno - 1))
     {
       leave_slide (renderer, TRUE);
-      pp_slidep = pp_slidep->prev;
+      pp_slideno--;
       show_slide (renderer, TRUE);
     }
 }
 
+static void
+goto_slide (ClutterRenderer *renderer,
+            gint             slideno)
+{
+  gboolean backwards = slideno < pp_slideno;
+
+  if (!pp_slide_nth (slideno) || slideno == pp_slideno)
+    return;
+
+  if (pp_slide_current ())
+    leave_slide (renderer, backwards);
+  pp_slideno = slideno;
+  show_slide (renderer, backwards);
+}
+
 static gboolean
 go_prev (ClutterActor *actor,
          ClutterEvent *event,
@@ -664,8 +767,9 @@ start (ClutterActor *actor,
   g_timer_stop (renderer->timer);
   g_timer_start (renderer->timer);
   renderer->timer_paused = FALSE;
-  leave_slide (renderer, TRUE);
-  pp_slidep = pp_slides;
+  if (pp_slide_current ())
+    leave_slide (renderer, TRUE);
+  pp_slideno = 0;
   play_pause (NULL, NULL, data);
   play_pause (NULL, NULL, data);
   if (pp_rehearse)
@@ -674,7 +778,6 @@ start (ClutterActor *actor,
     }
   pp_rehearse_init (); /* zeroes out the new-time */
   show_slide (renderer, TRUE);
-  renderer->reset = TRUE;
   return TRUE;
 }
 
@@ -907,6 +1010,400 @@ clutter_renderer_init_speaker_screen (ClutterRenderer *renderer)
                     G_CALLBACK (speaker_screen_deleted), renderer);
 }
 
+/*
+ * Frame statistics
+ *
+ * With --stats, or once F3 is pressed, the time between frames painted on
+ * the presentation stage is recorded for the current slide, and for its
+ * transition while that is animating. Frames are only counted as dropped
+ * during transitions, when the stage is meant to repaint at its frame rate;
+ * video backgrounds repaint at their own. Nothing is hooked into the paint
+ * cycle before that.
+ */
+
+#define STATS_IDLE_MS    250   /* longer gaps are the stage idling, not frames */
+#define STATS_BUCKETS    100   /* 1ms each, the last also counts slower ones */
+
+typedef struct _FrameStats
+{
+  gint    slideno;   /* of slide rows, where the slide was last shown */
+  guint   frames;
+  guint   dropped;   /* refresh intervals missed */
+  gdouble total_ms;
+  gdouble max_ms;
+  guint   histogram[STATS_BUCKETS];
+  guint   video_frames; /* shown by the slide's video, and those of them */
+  guint   video_late;   /* the video sink's QoS found late */
+} FrameStats;
+
+static FrameStats *
+frame_stats_get (GHashTable *table,
+                 gpointer    key)
+{
+  FrameStats *stats = g_hash_table_lookup (table, key);
+
+  if (!stats)
+    {
+      stats = g_slice_new0 (FrameStats);
+      g_hash_table_insert (table, key, stats);
+    }
+  return stats;
+}
+
+static void
+frame_stats_free (gpointer data)
+{
+  g_slice_free (FrameStats, data);
+}
+
+/* @frame_ms is the interval frames are expected at, 0 if none is */
+static void
+frame_stats_add (FrameStats *stats,
+                 gdouble     ms,
+                 gdouble     frame_ms)
+{
+  stats->frames++;
+  stats->total_ms += ms;
+  stats->max_ms = MAX (stats->max_ms, ms);
+  stats->histogram[MIN ((gint) ms, STATS_BUCKETS - 1)]++;
+
+  if (frame_ms > 0 && ms > frame_ms * 1.5)
+    stats->dropped += (guint) (ms / frame_ms + 0.5) - 1;
+}
+
+/* upper bound of the bucket holding the @percent th percentile, in ms */
+static gint
+frame_stats_percentile (FrameStats *stats,
+                        gdouble     percent)
+{
+  guint wanted = stats->frames * percent / 100.0;
+  guint seen = 0;
+  gint  i;
+
+  for (i = 0; i < STATS_BUCKETS - 1; i++)
+    {
+      seen += stats->histogram[i];
+      if (seen > wanted)
+        break;
+    }
+  return i + 1;
+}
+
+static void
+frame_stats_print (GString    *str,
+                   const char *label,
+                   FrameStats *stats)
+{
+  if (!stats || !stats->frames)
+    {
+      g_string_append_printf (str, "%-16s no frames\n", label);
+      return;
+    }
+
+  g_string_append_printf (str, "%-16s %5u frames  avg %5.1fms  "
+                          "p50 %2dms  p95 %2dms  p99 %2dms  max %5.1fms  "
+                          "%u dropped\n",
+                          label, stats->frames,
+                          stats->total_ms / stats->frames,
+                          frame_stats_percentile (stats, 50),
+                          frame_stats_percentile (stats, 95),
+                          frame_stats_percentile (stats, 99),
+                          stats->max_ms, stats->dropped);
+  if (stats->video_frames)
+    g_string_append_printf (str, "%-16s %5u video frames, %u late\n", "",
+                            stats->video_frames, stats->video_late);
+}
+
+static const char *
+frame_stats_transition (PinPointPoint *point)
+{
+  return g_intern_string (point->transition ? point->transition : "(none)");
+}
+
+/* The row of @point, shown as slide @slideno, NULL without statistics.
+ * Slides are told apart by a checksum of their source, so that their rows
+ * stay theirs when reloads or streaming move them around; slides with the
+ * same source share one.
+ */
+static FrameStats *
+stats_slide_get (ClutterRenderer *renderer,
+                 PinPointPoint   *point,
+                 gint             slideno)
+{
+  if (!renderer->stats_slides)
+    return NULL;
+
+  if (point != renderer->stats_point || point->source != renderer->stats_source)
+    {
+      char *key;
+
+      if (point->source)
+        key = g_compute_checksum_for_data (G_CHECKSUM_SHA1,
+                                           (const guchar *) point->source,
+                                           point->source_len);
+      else
+        key = g_compute_checksum_for_string (G_CHECKSUM_SHA1,
+                                             point->text ? point->text : "",
+                                             -1);
+
+      renderer->stats_current = g_hash_table_lookup (renderer->stats_slides,
+                                                     key);
+      if (renderer->stats_current)
+        g_free (key);
+      else
+        renderer->stats_current = frame_stats_get (renderer->stats_slides,
+                                                   key);
+      renderer->stats_point = point;
+      renderer->stats_source = point->source;
+    }
+
+  renderer->stats_current->slideno = slideno;
+  return renderer->stats_current;
+}
+
+static void
+stats_frame (ClutterActor *stage,
+             gpointer      data)
+{
+  ClutterRenderer *renderer = data;
+  PinPointPoint   *point = pp_slide_current ();
+  gint64           now = g_get_monotonic_time ();
+  gdouble          ms = (now - renderer->stats_last) / 1000.0;
+
+  if (point && renderer->stats_last && ms < STATS_IDLE_MS)
+    {
+      /* see pp_slide_set_animating () */
+      gdouble frame_ms = point->animating ? renderer->stats_frame_ms : 0;
+
+      frame_stats_add (stats_slide_get (renderer, point, pp_slideno),
+                       ms, frame_ms);
+      if (point->animating)
+        frame_stats_add (frame_stats_get (renderer->stats_transitions,
+                                          (gpointer) frame_stats_transition (point)),
+                         ms, frame_ms);
+    }
+  renderer->stats_last = now;
+}
+
+/* counts the iterations of the main loop, i.e. how often it wakes up */
+typedef struct
+{
+  GSource source;
+  guint   count;
+} WakeupCounter;
+
+static gboolean
+wakeup_counter_prepare (GSource *source,
+                        gint    *timeout)
+{
+  ((WakeupCounter *) source)->count++;
+  *timeout = -1;
+
+  return FALSE;
+}
+
+static gboolean
+wakeup_counter_check (GSource *source)
+{
+  return FALSE;
+}
+
+static GSourceFuncs wakeup_counter_funcs =
+{
+  wakeup_counter_prepare,
+  wakeup_counter_check,
+  NULL,
+  NULL
+};
+
+static void
+stats_print_wakeups (GString *str,
+                     guint    wakeups,
+                     gint64   usecs)
+{
+  g_string_append_printf (str, "%-16s %5.1f wakeups/s\n", "main loop",
+                          usecs > 0 ? wakeups * 1000000.0 / usecs : 0.0);
+}
+
+#ifdef USE_CLUTTER_GST
+static void video_stats_print (GString       *str,
+                               PinPointPoint *point);
+#endif
+
+static gboolean
+stats_overlay_update (gpointer data)
+{
+  ClutterRenderer *renderer = data;
+  PinPointPoint   *point = pp_slide_current ();
+  GString         *str;
+  char            *label;
+  guint            wakeups;
+  gint64           now;
+
+  if (!point)
+    return TRUE;
+
+  str = g_string_new (NULL);
+
+  label = g_strdup_printf ("slide %d", pp_slideno + 1);
+  frame_stats_print (str, label,
+                     stats_slide_get (renderer, point, pp_slideno));
+  g_free (label);
+  frame_stats_print (str, frame_stats_transition (point),
+                     g_hash_table_lookup (renderer->stats_transitions,
+                                          frame_stats_transition (point)));
+#ifdef USE_CLUTTER_GST
+  video_stats_print (str, point);
+#endif
+
+  /* this refresh itself adds two wakeups a second */
+  wakeups = ((WakeupCounter *) renderer->stats_wakeups)->count;
+  now = g_get_monotonic_time ();
+  stats_print_wakeups (str, wakeups - renderer->stats_wakeups_seen,
+                       now - renderer->stats_wakeups_time);
+  renderer->stats_wakeups_seen = wakeups;
+  renderer->stats_wakeups_time = now;
+
+  g_string_truncate (str, str->len - 1);
+  clutter_text_set_text (CLUTTER_TEXT (renderer->stats_overlay), str->str);
+  g_string_free (str, TRUE);
+
+  return TRUE;
+}
+
+static void
+stats_toggle (ClutterRenderer *renderer)
+{
+  ClutterColor shade = {0x00, 0x00, 0x00, 0xaa};
+
+  if (!renderer->stats_id)
+    {
+      renderer->stats_slides =
+        g_hash_table_new_full (g_str_hash, g_str_equal,
+                               g_free, frame_stats_free);
+      renderer->stats_transitions =
+        g_hash_table_new_full (NULL, NULL, NULL, frame_stats_free);
+      /* the rate the master clock paces the stage at, which follows
+       * CLUTTER_DEFAULT_FPS */
+      renderer->stats_frame_ms = 1000.0 / clutter_get_default_frame_rate ();
+      renderer->stats_id = g_signal_connect_after (renderer->stage, "paint",
+                                                   G_CALLBACK (stats_frame),
+                                                   renderer);
+
+      renderer->stats_wakeups = g_source_new (&wakeup_counter_funcs,
+                                              sizeof (WakeupCounter));
+      g_source_attach (renderer->stats_wakeups, NULL);
+      renderer->stats_start = g_get_monotonic_time ();
+      renderer->stats_cpu_start = clock ();
+      renderer->stats_wakeups_time = renderer->stats_start;
+
+      renderer->stats_overlay = clutter_text_new ();
+      clutter_text_set_font_name (CLUTTER_TEXT (renderer->stats_overlay),
+                                  "Monospace 10");
+      clutter_text_set_color (CLUTTER_TEXT (renderer->stats_overlay), &white);
+      clutter_actor_set_background_color (renderer->stats_overlay, &shade);
+      clutter_actor_add_child (renderer->stage, renderer->stats_overlay);
+      clutter_actor_hide (renderer->stats_overlay);
+    }
+
+  if (renderer->stats_overlay_id)
+    {
+      g_source_remove (renderer->stats_overlay_id);
+      renderer->stats_overlay_id = 0;
+      clutter_actor_hide (renderer->stats_overlay);
+    }
+  else
+    {
+      stats_overlay_update (renderer);
+      renderer->stats_overlay_id =
+        g_timeout_add (500, stats_overlay_update, renderer);
+      clutter_actor_show (renderer->stats_overlay);
+    }
+}
+
+/* by where the slides were last shown */
+static gint
+stats_compare_slides (gconstpointer a,
+                      gconstpointer b,
+                      gpointer      user_data)
+{
+  FrameStats *stats_a = g_hash_table_lookup (user_data, *(gpointer *) a);
+  FrameStats *stats_b = g_hash_table_lookup (user_data, *(gpointer *) b);
+
+  return stats_a->slideno - stats_b->slideno;
+}
+
+/* writes everything recorded to the cache directory */
+static void
+stats_save (ClutterRenderer *renderer)
+{
+  GString        *str;
+  GHashTableIter  iter;
+  GPtrArray      *slides;
+  gpointer        key, value;
+  char           *dir, *path, *label;
+  GError         *error = NULL;
+  guint           i;
+
+  str = g_string_new (NULL);
+  stats_print_wakeups (str, ((WakeupCounter *) renderer->stats_wakeups)->count,
+                       g_get_monotonic_time () - renderer->stats_start);
+  g_string_append_printf (str, "%-16s %5.1f%%\n", "cpu",
+                          100.0 * (clock () - renderer->stats_cpu_start) /
+                          CLOCKS_PER_SEC * 1000000.0 /
+                          MAX (g_get_monotonic_time () - renderer->stats_start, 1));
+#ifdef USE_CLUTTER_GST
+  if (renderer->video_starts)
+    g_string_append_printf (str, "%-16s %5.1fms avg %5.1fms max, %u starts\n",
+                            "video start",
+                            renderer->video_start_total / 1000.0 /
+                            renderer->video_starts,
+                            renderer->video_start_max / 1000.0,
+                            renderer->video_starts);
+#endif
+  g_string_append (str, "transitions:\n");
+  g_hash_table_iter_init (&iter, renderer->stats_transitions);
+  while (g_hash_table_iter_next (&iter, &key, &value))
+    frame_stats_print (str, key, value);
+
+  g_string_append (str, "slides:\n");
+  slides = g_ptr_array_new ();
+  g_hash_table_iter_init (&iter, renderer->stats_slides);
+  while (g_hash_table_iter_next (&iter, &key, NULL))
+    g_ptr_array_add (slides, key);
+  g_ptr_array_sort_with_data (slides, stats_compare_slides,
+                              renderer->stats_slides);
+  for (i = 0; i < slides->len; i++)
+    {
+      FrameStats *stats;
+
+      key = g_ptr_array_index (slides, i);
+      stats = g_hash_table_lookup (renderer->stats_slides, key);
+      /* the number is where it was last shown, the checksum of its source
+       * is what identifies it */
+      label = g_strdup_printf ("slide %d %.8s", stats->slideno + 1,
+                               (const char *) key);
+      frame_stats_print (str, label, stats);
+      g_free (label);
+    }
+  g_ptr_array_free (slides, TRUE);
+
+  dir = g_build_filename (g_get_user_cache_dir (), "pinpoint", NULL);
+  path = g_build_filename (dir, "stats.log", NULL);
+  g_mkdir_with_parents (dir, 0755);
+  if (g_file_set_contents (path, str->str, str->len, &error))
+    g_print ("frame statistics written to %s\n", path);
+  else
+    {
+      g_warning ("Could not write frame statistics: %s", error->message);
+      g_clear_error (&error);
+    }
+
+  g_free (path);
+  g_free (dir);
+  g_string_free (str, TRUE);
+}
+
 static gboolean
 stage_deleted (ClutterStage *stage,
                ClutterEvent *event,
@@ -931,11 +1428,14 @@ clutter_renderer_init (PinPointRenderer   *pp_renderer,
   clutter_stage_set_title(CLUTTER_STAGE(stage), "Pinpoint presentation");
   renderer->root = clutter_actor_new ();
   renderer->curtain = pp_rectangle_new_with_color (&black);
-  renderer->rest_y = STARTPOS;
+  renderer->jump_to = -1;
   renderer->background = clutter_actor_new ();
   renderer->midground = clutter_actor_new ();
   renderer->foreground = clutter_actor_new ();
   renderer->json_layer = clutter_actor_new ();
+  renderer->transitions =
+    g_hash_table_new_full (NULL, NULL, NULL, (GDestroyNotify) g_bytes_unref);
+  renderer->transition_pool = g_hash_table_new (NULL, NULL);
   renderer->shading = pp_rectangle_new_with_color (&black);
   renderer->commandline_shading = pp_rectangle_new_with_color (&black);
   renderer->commandline = clutter_text_new ();
@@ -1010,8 +1510,15 @@ clutter_renderer_init (PinPointRenderer   *pp_renderer,
   if (pp_fullscreen)
     pp_set_fullscreen (renderer, CLUTTER_STAGE (stage), TRUE);
 
+  if (pp_stats)
+    stats_toggle (renderer);
+
   renderer->path = pinpoint_file;
-  if (renderer->path)
+  if (pp_stream)
+    {
+      stream_open (renderer);
+    }
+  else if (renderer->path)
     {
       monitor = g_file_monitor (g_file_new_for_commandline_arg (pinpoint_file),
                                 G_FILE_MONITOR_NONE, NULL, NULL);
@@ -1019,12 +1526,35 @@ clutter_renderer_init (PinPointRenderer   *pp_renderer,
                                             renderer);
     }
 
-  renderer->bg_cache = g_hash_table_new_full (g_str_hash, g_str_equal,
-                                              NULL, _destroy_surface);
+  renderer->bg_cache = g_hash_table_new_full (NULL, NULL, NULL,
+                                              (GDestroyNotify) clutter_actor_destroy);
+  renderer->decode_jobs = g_hash_table_new_full (NULL, NULL,
+                                                 (GDestroyNotify) pp_asset_unref,
+                                                 g_free);
+  renderer->decode_shown = -1;
+#ifdef USE_CLUTTER_GST
+  renderer->videos = g_hash_table_new_full (NULL, NULL,
+                                            (GDestroyNotify) pp_asset_unref,
+                                            g_free);
+#endif
+  renderer->decode_pool = g_thread_pool_new (decode_run, NULL,
+                                             DECODE_THREADS, FALSE, NULL);
+  g_thread_pool_set_sort_function (renderer->decode_pool,
+                                   decode_compare, renderer);
 
   renderer->cairo_renderer = pp_cairo_renderer ();
   renderer->cairo_renderer->init (renderer->cairo_renderer, pinpoint_file);
 
+  /* one thread, the cairo renderer is not reentrant anyway */
+  g_mutex_init (&renderer->cairo_lock);
+  renderer->preview_pool = g_thread_pool_new (preview_run, NULL,
+                                              1, FALSE, NULL);
+  renderer->previews =
+    g_hash_table_new_full (g_str_hash, g_str_equal,
+                           g_free, (GDestroyNotify) cairo_surface_destroy);
+  renderer->preview_order = g_queue_new ();
+  renderer->preview_pending = g_hash_table_new (g_str_hash, g_str_equal);
+
   session_bus = g_bus_get_sync (G_BUS_TYPE_SESSION, NULL, NULL);
   if (session_bus != NULL)
     {
@@ -1044,7 +1574,8 @@ clutter_renderer_init (PinPointRenderer   *pp_renderer,
   renderer->dbus_input = pp_dbusinput_new (stage);
 }
 
-static gboolean update_speaker_screen (ClutterRenderer *renderer);
+static void     speaker_screen_queue (ClutterRenderer *renderer,
+                                      guint            dirty);
 
 static void
 clutter_renderer_run (PinPointRenderer *pp_renderer)
@@ -1056,7 +1587,6 @@ clutter_renderer_run (PinPointRenderer *pp_renderer)
   /* the presentaiton is not parsed at first initialization,.. */
   renderer->total_seconds = point_defaults->duration * 60;
 
-  g_timeout_add (15, (GSourceFunc)update_speaker_screen, renderer);
   clutter_main ();
 }
 
@@ -1065,103 +1595,1132 @@ clutter_renderer_finalize (PinPointRenderer *pp_renderer)
 {
   ClutterRenderer *renderer = CLUTTER_RENDERER (pp_renderer);
 
+  g_debug ("background decodes: %u hits, %u misses",
+           renderer->decode_hits, renderer->decode_misses);
+  g_debug ("background textures: %" G_GSIZE_FORMAT " KiB, "
+           "%" G_GSIZE_FORMAT " KiB at full size",
+           renderer->texture_bytes / 1024,
+           renderer->texture_bytes_full / 1024);
+#ifdef USE_CLUTTER_GST
+  if (renderer->video_starts)
+    g_debug ("first video frames: %.2fms on average, %.2fms at most",
+             renderer->video_start_total / 1000.0 / renderer->video_starts,
+             renderer->video_start_max / 1000.0);
+  if (renderer->video_frame_id)
+    clutter_threads_remove_repaint_func (renderer->video_frame_id);
+#endif
+
+  if (renderer->relayout_id)
+    clutter_threads_remove_repaint_func (renderer->relayout_id);
+  if (renderer->stats_id)
+    {
+      g_signal_handler_disconnect (renderer->stage, renderer->stats_id);
+      if (renderer->stats_overlay_id)
+        g_source_remove (renderer->stats_overlay_id);
+      stats_save (renderer);
+      g_source_destroy (renderer->stats_wakeups);
+      g_source_unref (renderer->stats_wakeups);
+      g_hash_table_unref (renderer->stats_slides);
+      g_hash_table_unref (renderer->stats_transitions);
+    }
   pp_dbusinput_free (renderer->dbus_input);
-  clutter_actor_destroy (renderer->stage);
+  /* drop what is still queued and wait for the running decodes; their
+   * results are never uploaded since the main loop has quit */
+  g_thread_pool_free (renderer->decode_pool, TRUE, TRUE);
+  g_thread_pool_free (renderer->preview_pool, TRUE, TRUE);
+  if (renderer->thumb_pool)
+    g_thread_pool_free (renderer->thumb_pool, TRUE, TRUE);
+  g_free (renderer->thumb_dir);
+  g_hash_table_unref (renderer->previews);
+  g_queue_free (renderer->preview_order);
+  g_hash_table_unref (renderer->preview_pending);
   g_hash_table_unref (renderer->bg_cache);
+  clutter_actor_destroy (renderer->stage);
+  g_hash_table_unref (renderer->decode_jobs);
+#ifdef USE_CLUTTER_GST
+  g_hash_table_unref (renderer->videos);
+#endif
   g_clear_object (&renderer->gsm);
 }
 
-static ClutterActor *
-_clutter_get_texture (ClutterRenderer *renderer,
-                      const char      *file)
+/*
+ * Background decoding
+ *
+ * Images are decoded on a small pool of worker threads, nearest to the
+ * current slide first, and only the texture upload happens in the main
+ * thread. Each asset has one DecodeJob for the lifetime of the renderer.
+ *
+ * Images are decoded at the size they are displayed at on the stage (the
+ * loaders can skip most of the work for that, e.g. JPEG's scaled DCT),
+ * while the source actor keeps the size of the file so the layout code
+ * does not need to know. A bigger stage triggers a new decode.
+ *
+ * The source actors live in bg_cache, and the slides show clones of them.
+ * Once the textures go over --texture-budget, the least recently used
+ * ones that no slide is showing and that are not wanted around the current
+ * slide are destroyed; they are decoded again when needed.
+ */
+
+typedef enum
 {
-  ClutterActor *source;
+  DECODE_IDLE,       /* not loaded, nor queued */
+  DECODE_QUEUED,     /* in the pool, or waiting for decode_done () */
+  DECODE_DONE        /* uploaded, or failed to load */
+} DecodeState;
 
-  source = g_hash_table_lookup (renderer->bg_cache, file);
-  if (source)
-    {
-      return clutter_clone_new (source);
-    }
+typedef struct
+{
+  ClutterRenderer *renderer;
+  PinPointAsset   *asset;
+  ClutterActor    *texture;   /* the source actor in bg_cache, NULL once
+                                 evicted */
+  guint            users;     /* clones of texture */
+  guint            used;      /* LRU stamp, from texture_clock */
+  DecodeState      state;     /* only touched by the main thread */
+  gint             slideno;   /* slide the pixels are wanted for, atomic */
+  gint             cancelled; /* atomic */
+  gint             width;     /* size wanted, G_MAXINT for the file's */
+  gint             height;    /* size; atomic */
+  gint             loaded_width;  /* size of the pixels in the texture */
+  gint             loaded_height;
+  gboolean         failed;
+  gint             decoded_width; /* size wanted by the running decode */
+  gint             decoded_height;
+  gsize            bytes;     /* texture memory used by the pixels */
+  gsize            full_bytes; /* the same at the file's size */
+  GdkPixbuf       *pixbuf;    /* result of the decode */
+  GError          *error;
+} DecodeJob;
 
-  source = g_object_new (CLUTTER_TYPE_TEXTURE,
-                         "filename", file,
-                         "load-data-async", TRUE,
-                         NULL);
+static gboolean
+decode_in_window (gint slideno)
+{
+  return slideno >= pp_slideno - pp_window_before &&
+         slideno <= pp_slideno + pp_window_after;
+}
 
-  if (!source)
-    return NULL;
+static gint
+decode_compare (gconstpointer a,
+                gconstpointer b,
+                gpointer      user_data)
+{
+  ClutterRenderer *renderer = user_data;
+  DecodeJob       *job_a = (DecodeJob *) a;
+  DecodeJob       *job_b = (DecodeJob *) b;
+  gint             current = g_atomic_int_get (&renderer->decode_current);
+  gint             dist_a, dist_b;
 
-  clutter_actor_add_child (renderer->stage, source);
-  clutter_actor_hide (source);
+  dist_a = g_atomic_int_get (&job_a->slideno) - current;
+  dist_b = g_atomic_int_get (&job_b->slideno) - current;
 
-  g_hash_table_insert (renderer->bg_cache, (char *) g_strdup (file), source);
+  /* slides behind the current one are less likely to be shown next */
+  dist_a = dist_a < 0 ? -2 * dist_a : dist_a;
+  dist_b = dist_b < 0 ? -2 * dist_b : dist_b;
 
-  return clutter_clone_new (source);
+  return dist_a - dist_b;
 }
 
-#if USE_CLUTTER_GST
+static gboolean decode_done        (gpointer         data);
+static void     texture_cache_trim (ClutterRenderer *renderer);
+
 static void
-on_size_changed (ClutterActor *texture,
-                 gint          width,
-                 gint          height,
-                 gpointer      user_data)
+decode_run (gpointer data,
+            gpointer user_data)
 {
-  PinPointRenderer *pp_renderer = user_data;
-  ClutterRenderer *renderer = CLUTTER_RENDERER (pp_renderer);
-  PinPointPoint *point;
-  ClutterPointData *data;
+  DecodeJob *job = data;
+  gint       width, height;
 
-  point = pp_slidep->data;
-  if (!point)
-    return;
+  if (g_atomic_int_get (&job->cancelled))
+    goto out;
 
-  data = point->data;
+  width = job->decoded_width = g_atomic_int_get (&job->width);
+  height = job->decoded_height = g_atomic_int_get (&job->height);
 
-  if (data->background != texture)
+  if (width == G_MAXINT || height == G_MAXINT)
+    job->pixbuf = gdk_pixbuf_new_from_file (job->asset->path, &job->error);
+  else
+    job->pixbuf = gdk_pixbuf_new_from_file_at_scale (job->asset->path,
+                                                     width, height, FALSE,
+                                                     &job->error);
+out:
+  g_idle_add (decode_done, job);
+}
+
+/* the size @point shows its background at on the stage, never bigger than
+ * the file itself
+ */
+static void
+decode_get_size (ClutterRenderer *renderer,
+                 PinPointPoint   *point,
+                 gint            *width,
+                 gint            *height)
+{
+  float bg_x, bg_y, bg_scale_x, bg_scale_y;
+  gint  file_width, file_height;
+
+  if (!pp_asset_get_size (point->asset, &file_width, &file_height))
     {
-      g_warning ("size changed but not current background ?!");
+      *width = *height = G_MAXINT;
       return;
     }
 
-  clutter_actor_set_size (texture, width, height);
-  pp_clutter_render_adjust_background (renderer, point);
+  pp_get_background_position_scale (point,
+                                    clutter_actor_get_width (renderer->stage),
+                                    clutter_actor_get_height (renderer->stage),
+                                    file_width, file_height,
+                                    &bg_x, &bg_y, &bg_scale_x, &bg_scale_y);
+
+  *width = CLAMP ((gint) (file_width * bg_scale_x + 0.5f), 1, file_width);
+  *height = CLAMP ((gint) (file_height * bg_scale_y + 0.5f), 1, file_height);
 }
 
-static gboolean
-setup_camera (PinPointRenderer *renderer,
-              PinPointPoint    *point)
+static void
+decode_queue (DecodeJob *job,
+              gint       slideno,
+              gint       width,
+              gint       height)
 {
-  /* These are static to be able to share the texture and the pipeline between
-   * all the slides using the camera */
-  static ClutterActor *texture = NULL;
-  static GstElement   *pipeline = NULL;
-
-  ClutterPointData *data = point->data;
-  GstElement       *src;
-  GstElement       *capsfilter;
-  GstElement       *sink;
-  GstCaps          *caps;
-  gboolean          result;
+  g_atomic_int_set (&job->slideno, slideno);
 
-  if (texture)
-    {
-      data->background = clutter_clone_new (texture);
-      data->pipeline = pipeline;
+  /* slides sharing a background get the biggest size any of them needs */
+  if (width > job->width)
+    g_atomic_int_set (&job->width, width);
+  if (height > job->height)
+    g_atomic_int_set (&job->height, height);
 
-      return TRUE;
-    }
+  if (job->failed || job->state == DECODE_QUEUED)
+    return;
 
-  texture = g_object_new (CLUTTER_TYPE_TEXTURE, "disable-slicing", TRUE, NULL);
+  if (job->state == DECODE_DONE &&
+      job->width <= job->loaded_width &&
+      job->height <= job->loaded_height)
+    return;
 
-  g_signal_connect (CLUTTER_TEXTURE (texture),
-                    "size-change",
-                    G_CALLBACK (on_size_changed), renderer);
+  job->state = DECODE_QUEUED;
+  g_atomic_int_set (&job->cancelled, FALSE);
+  g_thread_pool_push (job->renderer->decode_pool, job, NULL);
+}
 
-  /* Set up pipeline */
-  pipeline = gst_pipeline_new (NULL);
+static gboolean
+decode_done (gpointer data)
+{
+  DecodeJob       *job = data;
+  ClutterRenderer *renderer = job->renderer;
+  PinPointPoint   *point;
+  GError          *error = NULL;
 
-  src = gst_element_factory_make ("v4l2src", NULL);
-  if (src == NULL)
+  if (job->pixbuf)
+    {
+      GdkPixbuf *pixbuf = job->pixbuf;
+      gint       file_width, file_height;
+      gsize      bytes;
+
+      if (!clutter_texture_set_from_rgb_data (CLUTTER_TEXTURE (job->texture),
+                                              gdk_pixbuf_get_pixels (pixbuf),
+                                              gdk_pixbuf_get_has_alpha (pixbuf),
+                                              gdk_pixbuf_get_width (pixbuf),
+                                              gdk_pixbuf_get_height (pixbuf),
+                                              gdk_pixbuf_get_rowstride (pixbuf),
+                                              gdk_pixbuf_get_n_channels (pixbuf),
+                                              CLUTTER_TEXTURE_NONE,
+                                              &error))
+        {
+          g_warning ("Could not upload %s: %s", job->asset->path,
+                     error->message);
+          g_clear_error (&error);
+        }
+
+      bytes = gdk_pixbuf_get_width (pixbuf) * gdk_pixbuf_get_height (pixbuf) * 4;
+      if (!pp_asset_get_size (job->asset, &file_width, &file_height))
+        {
+          file_width = gdk_pixbuf_get_width (pixbuf);
+          file_height = gdk_pixbuf_get_height (pixbuf);
+        }
+
+      renderer->texture_bytes_full -= job->full_bytes;
+      job->full_bytes = (gsize) file_width * file_height * 4;
+      renderer->texture_bytes_full += job->full_bytes;
+      renderer->texture_bytes += bytes - job->bytes;
+      job->bytes = bytes;
+
+      g_debug ("decoded %s at %dx%d (file %dx%d): %" G_GSIZE_FORMAT " KiB, "
+               "%" G_GSIZE_FORMAT " KiB for all backgrounds",
+               job->asset->path,
+               gdk_pixbuf_get_width (pixbuf), gdk_pixbuf_get_height (pixbuf),
+               file_width, file_height, bytes / 1024,
+               renderer->texture_bytes / 1024);
+
+      job->loaded_width = job->decoded_width;
+      job->loaded_height = job->decoded_height;
+      g_clear_object (&job->pixbuf);
+      job->state = DECODE_DONE;
+
+      point = pp_slide_current ();
+      if (point && point->asset == job->asset && point->data)
+        pp_clutter_render_adjust_background (renderer, point);
+
+      texture_cache_trim (renderer);
+    }
+  else if (job->error)
+    {
+      g_warning ("Could not load %s: %s", job->asset->path,
+                 job->error->message);
+      g_clear_error (&job->error);
+      job->failed = TRUE;
+      job->state = DECODE_DONE;
+    }
+  else
+    {
+      /* cancelled; it may have been asked for again in the meantime */
+      job->state = job->bytes ? DECODE_DONE : DECODE_IDLE;
+      if (decode_in_window (job->slideno))
+        decode_queue (job, job->slideno, job->width, job->height);
+    }
+
+  return FALSE;
+}
+
+static DecodeJob *
+decode_job_get (ClutterRenderer *renderer,
+                PinPointAsset   *asset)
+{
+  DecodeJob    *job;
+  ClutterActor *source;
+  gint          width, height;
+
+  job = g_hash_table_lookup (renderer->decode_jobs, asset);
+  if (!job)
+    {
+      job = g_new0 (DecodeJob, 1);
+      job->renderer = renderer;
+      job->asset = asset;
+      job->state = DECODE_IDLE;
+      g_hash_table_insert (renderer->decode_jobs, pp_asset_ref (asset), job);
+    }
+
+  job->used = ++renderer->texture_clock;
+
+  if (job->texture)
+    return job;
+
+  source = g_object_new (CLUTTER_TYPE_TEXTURE, NULL);
+
+  /* lay the slide out at the right size before the pixels arrive */
+  if (pp_asset_get_size (asset, &width, &height))
+    clutter_actor_set_size (source, width, height);
+
+  clutter_actor_add_child (renderer->stage, source);
+  clutter_actor_hide (source);
+
+  g_hash_table_insert (renderer->bg_cache, asset, source);
+  job->texture = source;
+
+  return job;
+}
+
+static void
+texture_evict (DecodeJob *job)
+{
+  ClutterRenderer *renderer = job->renderer;
+
+  g_debug ("evicting %s, %" G_GSIZE_FORMAT " KiB",
+           job->asset->path, job->bytes / 1024);
+
+  renderer->texture_bytes -= job->bytes;
+  renderer->texture_bytes_full -= job->full_bytes;
+  job->bytes = job->full_bytes = 0;
+  job->width = job->height = 0;
+  job->loaded_width = job->loaded_height = 0;
+  job->state = DECODE_IDLE;
+  job->texture = NULL;
+
+  g_hash_table_remove (renderer->bg_cache, job->asset);
+}
+
+static void
+texture_cache_trim (ClutterRenderer *renderer)
+{
+  gsize           budget = (gsize) pp_texture_budget * 1024 * 1024;
+  GHashTableIter  iter;
+  DecodeJob      *job, *oldest;
+
+  if (pp_texture_budget <= 0)
+    return;
+
+  while (renderer->texture_bytes > budget)
+    {
+      oldest = NULL;
+
+      g_hash_table_iter_init (&iter, renderer->decode_jobs);
+      while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &job))
+        {
+          if (!job->bytes || job->users || job->state == DECODE_QUEUED ||
+              decode_in_window (job->slideno))
+            continue;
+
+          if (!oldest || job->used < oldest->used)
+            oldest = job;
+        }
+
+      if (!oldest)
+        break;
+
+      texture_evict (oldest);
+    }
+}
+
+static void
+texture_clone_destroyed (ClutterActor *clone,
+                         DecodeJob    *job)
+{
+  job->users--;
+}
+
+/* Called on every slide change: counts whether the current background was
+ * ready in time, queues the backgrounds of the slides around it and cancels
+ * the decodes that are no longer needed soon.
+ */
+static void
+decode_prefetch (ClutterRenderer *renderer)
+{
+  PinPointPoint  *point;
+  DecodeJob      *job;
+  GHashTableIter  iter;
+  gint            i, width, height;
+
+  g_atomic_int_set (&renderer->decode_current, pp_slideno);
+
+  point = pp_slide_nth (pp_slideno);
+  if (point && point->bg_type == PP_BG_IMAGE && point->asset &&
+      renderer->decode_shown != pp_slideno)
+    {
+      renderer->decode_shown = pp_slideno;
+      job = decode_job_get (renderer, point->asset);
+      if (job->bytes || job->failed)
+        renderer->decode_hits++;
+      else
+        renderer->decode_misses++;
+
+      g_debug ("background decodes: %u hits, %u misses",
+               renderer->decode_hits, renderer->decode_misses);
+    }
+
+  for (i = pp_slideno - pp_window_before; i <= pp_slideno + pp_window_after; i++)
+    {
+      point = pp_slide_nth (i);
+      if (point && point->bg_type == PP_BG_IMAGE && point->asset)
+        {
+          job = decode_job_get (renderer, point->asset);
+          decode_get_size (renderer, point, &width, &height);
+
+          /* nearer slides take over decodes queued for farther ones */
+          if (job->state == DECODE_QUEUED &&
+              decode_in_window (job->slideno) &&
+              ABS (job->slideno - pp_slideno) <= ABS (i - pp_slideno))
+            decode_queue (job, job->slideno, width, height);
+          else
+            decode_queue (job, i, width, height);
+        }
+    }
+
+  g_hash_table_iter_init (&iter, renderer->decode_jobs);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &job))
+    {
+      if (job->state == DECODE_QUEUED &&
+          !decode_in_window (g_atomic_int_get (&job->slideno)))
+        g_atomic_int_set (&job->cancelled, TRUE);
+    }
+
+  texture_cache_trim (renderer);
+
+  /* setting the sort function again re-sorts the queue around the
+   * new current slide */
+  g_thread_pool_set_sort_function (renderer->decode_pool,
+                                   decode_compare, renderer);
+}
+
+static ClutterActor *
+_clutter_get_texture (ClutterRenderer *renderer,
+                      PinPointPoint   *point)
+{
+  DecodeJob    *job;
+  ClutterActor *clone;
+  gint          width, height;
+
+  job = decode_job_get (renderer, point->asset);
+
+  /* made outside of decode_prefetch (), e.g. by the file monitor */
+  if (job->state == DECODE_IDLE)
+    {
+      decode_get_size (renderer, point, &width, &height);
+      decode_queue (job, MAX (pp_slideno, 0), width, height);
+    }
+
+  clone = clutter_clone_new (job->texture);
+  job->users++;
+  g_signal_connect (clone, "destroy",
+                    G_CALLBACK (texture_clone_destroyed), job);
+
+  return clone;
+}
+
+#if USE_CLUTTER_GST
+/*
+ * Video pipelines
+ *
+ * Like the images, each video file has one source actor that the slides
+ * showing it clone, so a clip used on several slides is only decoded once.
+ * The actor, and with it the whole GStreamer pipeline, only exists for the
+ * current slide, its neighbours, the slides still animating out and the
+ * next video slide within VIDEO_LOOKAHEAD slides: setting the file
+ * prerolls the pipeline to PAUSED, which uploads the first frame before the
+ * slide is shown. The other pipelines are torn down on every slide change
+ * and their clones left without a source until they are wanted again.
+ */
+
+#define VIDEO_LOOKAHEAD 8 /* slides past the window to look for the next
+                             video in */
+
+typedef struct _VideoPipe
+{
+  ClutterRenderer *renderer;
+  PinPointAsset   *asset;
+  ClutterActor    *texture; /* the ClutterGstVideoTexture, NULL when closed */
+  GList           *clones;  /* of texture, one per made slide */
+  guint            wanted;  /* video_clock of the last prefetch wanting it */
+
+  GstElement      *playbin; /* of texture */
+  GstBus          *bus;
+  gulong           async_done_id;
+  gulong           qos_id;
+  gboolean         prerolled;
+  gboolean         seeking;
+  gboolean         playing;
+  gfloat           seek_to; /* of the running seek */
+  gfloat           cue;     /* where its next slide starts, in seconds */
+  gfloat           at;      /* where it is paused, -1 when playing or not
+                               known yet */
+
+  GstElement      *scaler;  /* capsfilter in front of the video sink */
+  PPBackgroundScale bg_scale; /* of the slide it plays or is cued for */
+  gint             scaled_width;  /* size asked of scaler, 0 if none yet */
+  gint             scaled_height;
+  gboolean         flush;   /* the scaler caps changed, and the pipeline
+                               needs a flushing seek to pick them up */
+  struct _FrameStats *stats; /* row of the slide playing it, if any */
+  guint            frames;  /* shown since it started playing */
+  guint            late;    /* QoS messages since then */
+} VideoPipe;
+
+static void
+on_size_changed (ClutterActor *texture,
+                 gint          width,
+                 gint          height,
+                 gpointer      user_data)
+{
+  PinPointRenderer *pp_renderer = user_data;
+  ClutterRenderer *renderer = CLUTTER_RENDERER (pp_renderer);
+  PinPointPoint *point;
+  ClutterPointData *data;
+
+  point = pp_slide_current ();
+  if (!point)
+    return;
+
+  data = point->data;
+
+  if (data->background != texture)
+    {
+      g_warning ("size changed but not current background ?!");
+      return;
+    }
+
+  clutter_actor_set_size (texture, width, height);
+  pp_clutter_render_adjust_background (renderer, point);
+}
+
+static VideoPipe *
+video_pipe_get (ClutterRenderer *renderer,
+                PinPointAsset   *asset)
+{
+  VideoPipe *pipe;
+
+  pipe = g_hash_table_lookup (renderer->videos, asset);
+  if (!pipe)
+    {
+      pipe = g_new0 (VideoPipe, 1);
+      pipe->renderer = renderer;
+      pipe->asset = asset;
+      g_hash_table_insert (renderer->videos, pp_asset_ref (asset), pipe);
+    }
+
+  return pipe;
+}
+
+static gboolean
+video_first_frame (gpointer data)
+{
+  ClutterRenderer *renderer = data;
+  gint64           latency;
+
+  latency = g_get_monotonic_time () - renderer->slide_requested;
+  renderer->video_starts++;
+  renderer->video_start_total += latency;
+  renderer->video_start_max = MAX (renderer->video_start_max, latency);
+
+  g_debug ("first video frame on screen %.2fms after the slide change",
+           latency / 1000.0);
+
+  renderer->video_frame_id = 0;
+  return FALSE;
+}
+
+/* The frame @pipe is to start with is in its texture: when that is the
+ * video of the current slide, the latency is taken after the next paint.
+ */
+static void
+video_frame_ready (VideoPipe *pipe)
+{
+  ClutterRenderer *renderer = pipe->renderer;
+
+  if (renderer->video_waiting != pipe)
+    return;
+
+  renderer->video_waiting = NULL;
+  if (!renderer->video_frame_id)
+    renderer->video_frame_id =
+      clutter_threads_add_repaint_func_full (CLUTTER_REPAINT_FLAGS_POST_PAINT |
+                                             CLUTTER_REPAINT_FLAGS_QUEUE_REDRAW_ON_ADD,
+                                             video_first_frame, renderer, NULL);
+}
+
+static void
+video_pipe_seek (VideoPipe *pipe)
+{
+  pipe->flush = FALSE;
+  pipe->seeking = TRUE;
+  pipe->seek_to = pipe->cue;
+  pipe->at = -1.0;
+  gst_element_seek_simple (pipe->playbin, GST_FORMAT_TIME,
+                           GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_ACCURATE,
+                           (gint64) (pipe->cue * GST_SECOND));
+}
+
+/* Has the pipeline scale the video down to the size its slide shows it
+ * at, like decode_get_size () does for images; the source actor keeps the
+ * size of the file. Nothing is done before that size is known, i.e. the
+ * first time a file is prerolled. Returns whether the caps changed, which
+ * a pipeline past READY only picks up after video_pipe_flush ().
+ */
+static gboolean
+video_pipe_scale (VideoPipe *pipe)
+{
+  PinPointPoint  point = { 0, };
+  GstCaps       *caps;
+  gint           width, height;
+  gboolean       changed;
+
+  if (!pipe->scaler)
+    return FALSE;
+
+  point.asset = pipe->asset;
+  point.bg_scale = pipe->bg_scale;
+  decode_get_size (pipe->renderer, &point, &width, &height);
+  if (width == G_MAXINT)
+    return FALSE;
+
+  if (width >= pipe->asset->width && height >= pipe->asset->height)
+    {
+      width = pipe->asset->width;
+      height = pipe->asset->height;
+      caps = gst_caps_new_any ();
+    }
+  else
+    {
+      /* even sizes, that all the YUV layouts can be scaled to */
+      width = MAX (width & ~1, 2);
+      height = MAX (height & ~1, 2);
+      caps = gst_caps_new_simple ("video/x-raw-yuv",
+                                  "width", G_TYPE_INT, width,
+                                  "height", G_TYPE_INT, height,
+                                  NULL);
+      gst_caps_append (caps, gst_caps_new_simple ("video/x-raw-rgb",
+                                                  "width", G_TYPE_INT, width,
+                                                  "height", G_TYPE_INT, height,
+                                                  NULL));
+    }
+
+  changed = width != pipe->scaled_width || height != pipe->scaled_height;
+  if (changed)
+    {
+      g_debug ("decoding %s at %dx%d", pipe->asset->path, width, height);
+      pipe->scaled_width = width;
+      pipe->scaled_height = height;
+      g_object_set (pipe->scaler, "caps", caps, NULL);
+    }
+  gst_caps_unref (caps);
+
+  return changed;
+}
+
+/* Renegotiates the scaler caps of a running pipeline with a flushing seek
+ * to where it is, or once the preroll or seek in progress is done.
+ */
+static void
+video_pipe_flush (VideoPipe *pipe)
+{
+  GstFormat format = GST_FORMAT_TIME;
+  gint64    position;
+
+  pipe->flush = TRUE;
+  if (!pipe->prerolled || pipe->seeking)
+    return; /* see video_pipe_async_done () */
+
+  if (!pipe->playing)
+    {
+      video_pipe_seek (pipe);
+    }
+  else if (gst_element_query_position (pipe->playbin, &format, &position))
+    {
+      pipe->flush = FALSE;
+      gst_element_seek_simple (pipe->playbin, GST_FORMAT_TIME,
+                               GST_SEEK_FLAG_FLUSH, position);
+    }
+}
+
+/* Makes the pipeline wait at the start of @point, with that frame in its
+ * texture, so that showing the slide does not need to seek. Seeks are
+ * only possible once the pipeline prerolled, and one at a time.
+ */
+static void
+video_pipe_cue (VideoPipe     *pipe,
+                PinPointPoint *point)
+{
+  pipe->bg_scale = point->bg_scale;
+  pipe->cue = point->video_start;
+  if (video_pipe_scale (pipe))
+    video_pipe_flush (pipe);
+
+  if (pipe->prerolled && !pipe->seeking && pipe->at != pipe->cue)
+    video_pipe_seek (pipe);
+}
+
+/* the pipeline prerolled, or finished a seek */
+static void
+video_pipe_async_done (GstBus     *bus,
+                       GstMessage *message,
+                       VideoPipe  *pipe)
+{
+  gfloat reached;
+
+  if (GST_MESSAGE_SRC (message) != GST_OBJECT (pipe->playbin))
+    return;
+
+  if (!pipe->prerolled)
+    {
+      pipe->prerolled = TRUE;
+      reached = 0.0;
+    }
+  else if (pipe->seeking)
+    {
+      pipe->seeking = FALSE;
+      reached = pipe->seek_to;
+    }
+  else
+    {
+      return;
+    }
+
+  /* cued elsewhere in the meantime, or scaled differently */
+  if (reached != pipe->cue || pipe->flush)
+    {
+      video_pipe_seek (pipe);
+      return;
+    }
+
+  pipe->at = pipe->playing ? -1.0 : reached;
+  video_frame_ready (pipe);
+}
+
+/* starts playing from the start of @point, straight away when it was
+ * cued there */
+static void
+video_pipe_play (VideoPipe     *pipe,
+                 PinPointPoint *point)
+{
+  gboolean cued;
+
+  pipe->renderer->video_waiting = pipe;
+  pipe->stats = stats_slide_get (pipe->renderer, point, pp_slideno);
+  pipe->frames = pipe->late = 0;
+  video_pipe_cue (pipe, point);
+  cued = pipe->at == point->video_start; /* and not seeking there */
+  pipe->playing = TRUE;
+  pipe->at = -1.0;
+  clutter_media_set_playing (CLUTTER_MEDIA (pipe->texture), TRUE);
+
+  if (cued)
+    video_frame_ready (pipe);
+}
+
+static void
+video_pipe_stop (VideoPipe *pipe)
+{
+  ClutterRenderer *renderer = pipe->renderer;
+
+  if (renderer->video_waiting == pipe)
+    renderer->video_waiting = NULL;
+
+  if (pipe->playing)
+    {
+      g_debug ("%s: %u video frames, %u late", pipe->asset->path,
+               pipe->frames, pipe->late);
+      if (pipe->stats)
+        {
+          pipe->stats->video_frames += pipe->frames;
+          pipe->stats->video_late += pipe->late;
+        }
+    }
+
+  pipe->stats = NULL;
+  pipe->playing = FALSE;
+  pipe->at = -1.0;
+  clutter_media_set_playing (CLUTTER_MEDIA (pipe->texture), FALSE);
+}
+
+/* a frame was late, and dropped or shown late, somewhere in the pipeline */
+static void
+video_pipe_qos (GstBus     *bus,
+                GstMessage *message,
+                VideoPipe  *pipe)
+{
+  if (pipe->playing)
+    pipe->late++;
+}
+
+static void
+video_pipe_frame (ClutterTexture *texture,
+                  VideoPipe      *pipe)
+{
+  if (pipe->playing)
+    pipe->frames++;
+}
+
+/* the frames of the video @point is playing so far, for the overlay */
+static void
+video_stats_print (GString       *str,
+                   PinPointPoint *point)
+{
+  ClutterPointData *data = point->data;
+
+  if (data && data->video && data->video->playing)
+    g_string_append_printf (str, "%-16s %5u video frames, %u late\n",
+                            "playing", data->video->frames, data->video->late);
+}
+
+static void
+video_pipe_size_changed (ClutterActor *texture,
+                         gint          width,
+                         gint          height,
+                         VideoPipe    *pipe)
+{
+  ClutterRenderer  *renderer = pipe->renderer;
+  PinPointPoint    *point;
+  ClutterPointData *data;
+
+  /* until the pipeline scales, this is the size of the file */
+  if (!pipe->scaled_width)
+    {
+      pipe->asset->width = width;
+      pipe->asset->height = height;
+      pipe->asset->probed = TRUE;
+      if (video_pipe_scale (pipe))
+        video_pipe_flush (pipe);
+    }
+
+  clutter_actor_set_size (texture, pipe->asset->width, pipe->asset->height);
+
+  point = pp_slide_current ();
+  data = point ? point->data : NULL;
+  if (data && data->video == pipe)
+    pp_clutter_render_adjust_background (renderer, point);
+}
+
+/* lets the software decoders use all the cores */
+static void
+video_element_added (GstBin     *bin,
+                     GstElement *element,
+                     gpointer    data)
+{
+  gint threads;
+
+  if (GST_IS_BIN (element))
+    {
+      g_signal_connect (element, "element-added",
+                        G_CALLBACK (video_element_added), data);
+    }
+  else if (g_object_class_find_property (G_OBJECT_GET_CLASS (element),
+                                         "max-threads"))
+    {
+#if GLIB_CHECK_VERSION (2, 36, 0)
+      threads = g_get_num_processors ();
+#else
+      threads = MAX (sysconf (_SC_NPROCESSORS_ONLN), 1);
+#endif
+      g_object_set (element, "max-threads", threads, NULL);
+    }
+}
+
+/* Puts videoscale and a capsfilter in front of the video sink of the
+ * texture, and has the sink drop frames that are too late to be shown.
+ */
+static void
+video_pipe_add_scaler (VideoPipe *pipe)
+{
+  GstElement *bin, *scale, *filter, *sink = NULL;
+  GstPad     *pad;
+
+  g_object_get (pipe->playbin, "video-sink", &sink, NULL);
+  scale = gst_element_factory_make ("videoscale", NULL);
+  filter = gst_element_factory_make ("capsfilter", NULL);
+  if (!sink || !scale || !filter)
+    {
+      g_warning ("Could not scale %s in the pipeline", pipe->asset->path);
+      if (sink)
+        gst_object_unref (sink);
+      if (scale)
+        gst_object_unref (scale);
+      if (filter)
+        gst_object_unref (filter);
+      return;
+    }
+
+  g_object_set (sink,
+                "qos", TRUE,
+                "max-lateness", (gint64) 20 * GST_MSECOND,
+                NULL);
+
+  /* the playbin lets go of its sink, which it has not used yet */
+  g_object_set (pipe->playbin, "video-sink", NULL, NULL);
+
+  bin = gst_bin_new (NULL);
+  gst_bin_add_many (GST_BIN (bin), scale, filter, sink, NULL);
+  gst_element_link_many (scale, filter, sink, NULL);
+  pad = gst_element_get_static_pad (scale, "sink");
+  gst_element_add_pad (bin, gst_ghost_pad_new ("sink", pad));
+  gst_object_unref (pad);
+  gst_object_unref (sink);
+
+  g_object_set (pipe->playbin, "video-sink", bin, NULL);
+  pipe->scaler = filter;
+}
+
+static void
+video_pipe_open (VideoPipe *pipe)
+{
+  ClutterRenderer *renderer = pipe->renderer;
+  GList           *l;
+
+  if (pipe->texture)
+    return;
+
+  g_debug ("prerolling %s", pipe->asset->path);
+
+  pipe->texture = clutter_gst_video_texture_new ();
+  g_signal_connect (CLUTTER_TEXTURE (pipe->texture),
+                    "size-change",
+                    G_CALLBACK (video_pipe_size_changed), pipe);
+  g_signal_connect (CLUTTER_TEXTURE (pipe->texture),
+                    "pixbuf-change",
+                    G_CALLBACK (video_pipe_frame), pipe);
+
+  pipe->prerolled = pipe->seeking = pipe->playing = FALSE;
+  pipe->cue = 0.0;
+  pipe->at = -1.0;
+  pipe->playbin = clutter_gst_video_texture_get_pipeline (
+                    CLUTTER_GST_VIDEO_TEXTURE (pipe->texture));
+  pipe->bus = gst_element_get_bus (pipe->playbin);
+  gst_bus_add_signal_watch (pipe->bus);
+  pipe->async_done_id = g_signal_connect (pipe->bus, "message::async-done",
+                                          G_CALLBACK (video_pipe_async_done),
+                                          pipe);
+  pipe->qos_id = g_signal_connect (pipe->bus, "message::qos",
+                                   G_CALLBACK (video_pipe_qos), pipe);
+  g_signal_connect (pipe->playbin, "element-added",
+                    G_CALLBACK (video_element_added), NULL);
+
+  pipe->scaler = NULL;
+  pipe->scaled_width = pipe->scaled_height = 0;
+  pipe->flush = FALSE;
+  video_pipe_add_scaler (pipe);
+  if (pipe->asset->probed)
+    video_pipe_scale (pipe); /* in NULL, nothing to flush yet */
+
+  clutter_actor_add_child (renderer->stage, pipe->texture);
+  clutter_actor_hide (pipe->texture);
+  clutter_media_set_filename (CLUTTER_MEDIA (pipe->texture),
+                              pipe->asset->path);
+
+  for (l = pipe->clones; l; l = l->next)
+    clutter_clone_set_source (l->data, pipe->texture);
+}
+
+static void
+video_pipe_close (VideoPipe *pipe)
+{
+  GList *l;
+
+  if (!pipe->texture)
+    return;
+
+  g_debug ("releasing %s", pipe->asset->path);
+
+  for (l = pipe->clones; l; l = l->next)
+    clutter_clone_set_source (l->data, NULL);
+
+  if (pipe->renderer->video_waiting == pipe)
+    pipe->renderer->video_waiting = NULL;
+
+  g_signal_handler_disconnect (pipe->bus, pipe->async_done_id);
+  g_signal_handler_disconnect (pipe->bus, pipe->qos_id);
+  gst_bus_remove_signal_watch (pipe->bus);
+  gst_object_unref (pipe->bus);
+  pipe->bus = NULL;
+  pipe->playbin = NULL;
+  pipe->scaler = NULL;
+
+  clutter_media_set_playing (CLUTTER_MEDIA (pipe->texture), FALSE);
+  clutter_actor_destroy (pipe->texture);
+  pipe->texture = NULL;
+}
+
+static void
+video_clone_destroyed (ClutterActor *clone,
+                       VideoPipe    *pipe)
+{
+  pipe->clones = g_list_remove (pipe->clones, clone);
+}
+
+static ClutterActor *
+_clutter_get_video (ClutterRenderer *renderer,
+                    PinPointPoint   *point)
+{
+  ClutterPointData *data = point->data;
+  VideoPipe        *pipe;
+  ClutterActor     *clone;
+
+  pipe = video_pipe_get (renderer, point->asset);
+
+  clone = clutter_clone_new (pipe->texture);
+  pipe->clones = g_list_prepend (pipe->clones, clone);
+  g_signal_connect (clone, "destroy",
+                    G_CALLBACK (video_clone_destroyed), pipe);
+
+  data->video = pipe;
+
+  return clone;
+}
+
+/* Called on every slide change: opens the pipelines of the current slide,
+ * the slides next to it that may still be animating and the next video
+ * slide, cues the latter at its start, and closes all the others.
+ */
+static void
+video_prefetch (ClutterRenderer *renderer)
+{
+  PinPointPoint  *point, *current, *next = NULL;
+  VideoPipe      *pipe;
+  GHashTableIter  iter;
+  GList          *l;
+  guint           open = 0;
+  gint            i;
+
+  renderer->video_clock++;
+
+  /* a slide going away mid-transition keeps playing until it is gone */
+  for (l = pp_slides_animating (); l; l = l->next)
+    {
+      point = l->data;
+      if (point->bg_type == PP_BG_VIDEO)
+        video_pipe_get (renderer, point->asset)->wanted = renderer->video_clock;
+    }
+
+  for (i = MAX (pp_slideno - 1, 0);
+       i <= pp_slideno + pp_window_after + VIDEO_LOOKAHEAD &&
+       (point = pp_slide_nth (i));
+       i++)
+    {
+      if (point->bg_type != PP_BG_VIDEO)
+        continue;
+
+      video_pipe_get (renderer, point->asset)->wanted = renderer->video_clock;
+      if (i > pp_slideno)
+        {
+          next = point;
+          break;
+        }
+    }
+
+  g_hash_table_iter_init (&iter, renderer->videos);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &pipe))
+    {
+      if (pipe->wanted == renderer->video_clock)
+        {
+          video_pipe_open (pipe);
+          open++;
+        }
+      else
+        {
+          video_pipe_close (pipe);
+        }
+    }
+
+  if (open)
+    g_debug ("%u of %u video pipelines open", open,
+             g_hash_table_size (renderer->videos));
+
+  /* unless the current slide is about to play the same file */
+  current = pp_slide_nth (pp_slideno);
+  if (next && !(current->bg_type == PP_BG_VIDEO &&
+                current->asset == next->asset))
+    video_pipe_cue (video_pipe_get (renderer, next->asset), next);
+}
+
+static gboolean
+setup_camera (PinPointRenderer *renderer,
+              PinPointPoint    *point)
+{
+  /* These are static to be able to share the texture and the pipeline between
+   * all the slides using the camera */
+  static ClutterActor *texture = NULL;
+  static GstElement   *pipeline = NULL;
+
+  ClutterPointData *data = point->data;
+  GstElement       *src;
+  GstElement       *capsfilter;
+  GstElement       *sink;
+  GstCaps          *caps;
+  gboolean          result;
+
+  if (texture)
+    {
+      data->background = clutter_clone_new (texture);
+      data->pipeline = pipeline;
+
+      return TRUE;
+    }
+
+  texture = g_object_new (CLUTTER_TYPE_TEXTURE, "disable-slicing", TRUE, NULL);
+
+  g_signal_connect (CLUTTER_TEXTURE (texture),
+                    "size-change",
+                    G_CALLBACK (on_size_changed), renderer);
+
+  /* Set up pipeline */
+  pipeline = gst_pipeline_new (NULL);
+
+  src = gst_element_factory_make ("v4l2src", NULL);
+  if (src == NULL)
     {
       g_critical ("Failed to create v4l2src element");
       g_object_unref (pipeline);
@@ -1222,20 +2781,9 @@ clutter_renderer_make_point (PinPointRenderer *pp_renderer,
 {
   ClutterRenderer  *renderer  = CLUTTER_RENDERER (pp_renderer);
   ClutterPointData *data      = point->data;
-  const char       *file      = point->bg;
-        char       *full_path = NULL;
   ClutterColor color;
   gboolean ret = FALSE;
 
-  if (point->bg_type != PP_BG_COLOR && renderer->path && file)
-    {
-      char *dir = g_path_get_dirname (renderer->path);
-      full_path = g_build_filename (dir, file, NULL);
-      g_free (dir);
-
-      file = full_path;
-    }
-
   switch (point->bg_type)
     {
     case PP_BG_COLOR:
@@ -1266,16 +2814,12 @@ clutter_renderer_make_point (PinPointRenderer *pp_renderer,
      }
       break;
     case PP_BG_IMAGE:
-      data->background = _clutter_get_texture (renderer, file);
+      data->background = _clutter_get_texture (renderer, point);
       ret = TRUE;
       break;
     case PP_BG_VIDEO:
 #ifdef USE_CLUTTER_GST
-      data->background = clutter_gst_video_texture_new ();
-      clutter_media_set_filename (CLUTTER_MEDIA (data->background), file);
-      g_signal_connect (CLUTTER_TEXTURE (data->background),
-                        "size-change",
-                        G_CALLBACK (on_size_changed), renderer);
+      data->background = _clutter_get_video (renderer, point);
       ret = TRUE;
 #endif
       break;
@@ -1287,6 +2831,7 @@ clutter_renderer_make_point (PinPointRenderer *pp_renderer,
     case PP_BG_SVG:
 #ifdef USE_DAX
       {
+        const char   *file = point->asset ? point->asset->path : point->bg;
         ClutterActor *aa, *svg;
         GError *error = NULL;
 
@@ -1312,8 +2857,6 @@ clutter_renderer_make_point (PinPointRenderer *pp_renderer,
       g_assert_not_reached();
     }
 
-  g_free (full_path);
-
   if (data->background)
     {
       clutter_actor_add_child (renderer->background, data->background);
@@ -1344,9 +2887,9 @@ clutter_renderer_make_point (PinPointRenderer *pp_renderer,
 
   clutter_actor_add_child (renderer->foreground, data->text);
 
-  clutter_actor_set_position (data->text, RESTX, renderer->rest_y);
-  data->rest_y = renderer->rest_y;
-  renderer->rest_y += clutter_actor_get_height (data->text);
+  /* the texts rest in slide order, wherever slides are made again */
+  data->rest_y = STARTPOS + RESTSTEP * MAX (pp_slide_index (point), 0);
+  clutter_actor_set_position (data->text, RESTX, data->rest_y);
   clutter_actor_set_z_position (data->text, RESTDEPTH);
 
   return ret;
@@ -1366,14 +2909,14 @@ clutter_renderer_free_data (PinPointRenderer *renderer,
 {
   ClutterPointData *data = datap;
 
+  if (data->animation_id)
+    g_source_remove (data->animation_id);
   if (data->background)
     clutter_actor_destroy (data->background);
   if (data->text)
     clutter_actor_destroy (data->text);
-  if (data->json_slide)
-    clutter_actor_destroy (data->json_slide);
   if (data->script)
-    g_object_unref (data->script);
+    transition_release (CLUTTER_RENDERER (renderer), data);
   g_slice_free (ClutterPointData, data);
 }
 
@@ -1389,6 +2932,8 @@ static void end_of_presentation (ClutterRenderer *renderer)
 }
 
 
+static gboolean speaker_screen_tick (gpointer data);
+
 static void
 toggle_speaker_screen (ClutterRenderer *renderer)
 {
@@ -1398,11 +2943,16 @@ toggle_speaker_screen (ClutterRenderer *renderer)
     {
       renderer->speaker_mode = FALSE;
       clutter_actor_hide (renderer->speaker_screen);
+      g_source_remove (renderer->speaker_tick);
+      renderer->speaker_tick = 0;
     }
   else
     {
       renderer->speaker_mode = TRUE;
       clutter_actor_show (renderer->speaker_screen);
+      renderer->speaker_tick = g_timeout_add_seconds (1, speaker_screen_tick,
+                                                      renderer);
+      speaker_screen_queue (renderer, SPEAKER_ALL);
     }
 }
 
@@ -1470,7 +3020,27 @@ key_pressed (ClutterActor    *actor,
              ClutterEvent    *event,
              ClutterRenderer *renderer)
 {
-  if (event) /* There is no event for the first triggering */
+  gunichar c;
+  gint     jump_to;
+
+  if (!event) /* There is no event for the first triggering */
+    return TRUE;
+
+  renderer->input_time = g_get_monotonic_time ();
+
+  /* typing a slide number followed by Enter jumps straight to that slide */
+  c = clutter_event_get_key_unicode (event);
+  if (c >= '0' && c <= '9')
+    {
+      if (renderer->jump_to < 0)
+        renderer->jump_to = 0;
+      if (renderer->jump_to < G_MAXINT / 10 - 1)
+        renderer->jump_to = renderer->jump_to * 10 + (c - '0');
+      return TRUE;
+    }
+  jump_to = renderer->jump_to;
+  renderer->jump_to = -1;
+
   switch (clutter_event_get_key_symbol (event))
     {
       case CLUTTER_Left:
@@ -1486,6 +3056,14 @@ key_pressed (ClutterActor    *actor,
         next_slide (renderer);
         break;
       case CLUTTER_Escape:
+        if (jump_to >= 0) /* only cancel the slide number being typed */
+          break;
+        if (renderer->overview)
+          {
+            overview_toggle (renderer);
+            break;
+          }
+        /* flow through */
       case CLUTTER_Q:
       case CLUTTER_q:
         clutter_main_quit ();
@@ -1507,6 +3085,10 @@ key_pressed (ClutterActor    *actor,
           renderer->autoadvance = FALSE;
         else
           renderer->autoadvance = TRUE;
+        autoadvance_schedule (renderer);
+        break;
+      case CLUTTER_F3:
+        stats_toggle (renderer);
         break;
       case CLUTTER_F11:
         case CLUTTER_F:
@@ -1527,11 +3109,20 @@ key_pressed (ClutterActor    *actor,
         }
         break;
       case CLUTTER_Return:
-        action_slide (renderer);
+      case CLUTTER_KP_Enter:
+        if (jump_to >= 0)
+          goto_slide (renderer,
+                      CLAMP (jump_to, 1, (gint) pp_slide_count ()) - 1);
+        else
+          action_slide (renderer);
         break;
       case CLUTTER_Tab:
         activate_commandline (renderer);
         break;
+      case CLUTTER_o:
+      case CLUTTER_O:
+        overview_toggle (renderer);
+        break;
       case CLUTTER_b:
       case CLUTTER_B:
         if (CLUTTER_ACTOR_IS_VISIBLE (renderer->curtain))
@@ -1553,6 +3144,8 @@ mouse_clicked (ClutterActor    *actor,
                ClutterEvent    *event,
                ClutterRenderer *renderer)
 {
+  renderer->input_time = g_get_monotonic_time ();
+
   if(event)
   switch (clutter_event_get_button(event))
   {
@@ -1567,14 +3160,45 @@ mouse_clicked (ClutterActor    *actor,
 }
 
 
+#define ANIMATION_SLACK_MS 100
+
+static gboolean
+slide_animation_done (gpointer user_data)
+{
+  PinPointPoint    *point = user_data;
+  ClutterPointData *data  = point->data;
+
+  data->animation_id = 0;
+  pp_slide_set_animating (point, FALSE);
+
+  return FALSE;
+}
+
+/* Marks @point as animating for the next @ms, see pp_slide_set_animating ().
+ * Transitions end earlier in state_completed (), the timeout is for states
+ * that never report completing.
+ */
+static void
+slide_animation_start (PinPointPoint *point,
+                       guint          ms)
+{
+  ClutterPointData *data = point->data;
+
+  pp_slide_set_animating (point, TRUE);
+  if (data->animation_id)
+    g_source_remove (data->animation_id);
+  data->animation_id = g_timeout_add (ms + ANIMATION_SLACK_MS,
+                                      slide_animation_done, point);
+}
+
 static void leave_slide (ClutterRenderer *renderer,
                          gboolean         backwards)
 {
-  PinPointPoint *point = pp_slidep->data;
+  PinPointPoint *point = pp_slide_current ();
   ClutterPointData *data = point->data;
 
-  point->new_duration += g_timer_elapsed (renderer->timer, NULL) -
-                                          renderer->slide_start_time;
+  pp_rehearse_add (pp_slideno, g_timer_elapsed (renderer->timer, NULL) -
+                               renderer->slide_start_time);
 
   if (!point->transition)
     {
@@ -1593,15 +3217,18 @@ static void leave_slide (ClutterRenderer *renderer,
                             "opacity",      0x0,
                             NULL);
         }
+      slide_animation_start (point, 2000);
     }
   else
     {
       if (data->script)
         {
-          if (backwards)
-            clutter_state_set_state (data->state, "pre");
-          else
-            clutter_state_set_state (data->state, "post");
+          const char *state = backwards ? "pre" : "post";
+
+          clutter_state_set_state (data->state, state);
+          slide_animation_start (point,
+                                 clutter_state_get_duration (data->state,
+                                                             NULL, state));
         }
     }
 
@@ -1612,10 +3239,9 @@ static void leave_slide (ClutterRenderer *renderer,
         {
           gst_element_set_state (data->pipeline, GST_STATE_PAUSED);
         }
-      if (CLUTTER_GST_IS_VIDEO_TEXTURE (data->background))
+      if (data->video && data->video->texture)
         {
-          clutter_media_set_playing (CLUTTER_MEDIA (data->background),
-                                     FALSE);
+          video_pipe_stop (data->video);
         }
 #endif
 #ifdef USE_DAX
@@ -1640,6 +3266,13 @@ static void state_completed (ClutterState *state, gpointer user_data)
   ClutterPointData *data      = point->data;
   const char       *new_state = clutter_state_get_state (state);
 
+  if (data->animation_id)
+    {
+      g_source_remove (data->animation_id);
+      data->animation_id = 0;
+    }
+  pp_slide_set_animating (point, FALSE);
+
   if (new_state == g_intern_static_string ("post") ||
       new_state == g_intern_static_string ("pre"))
     {
@@ -1668,10 +3301,9 @@ action_slide (ClutterRenderer *renderer)
   ClutterPointData *data;
   const char       *command = NULL;
 
-  if (!pp_slidep)
+  point = pp_slide_current ();
+  if (!point)
     return;
-
-  point = pp_slidep->data;
   data = point->data;
 
   if (data->state)
@@ -1687,19 +3319,244 @@ action_slide (ClutterRenderer *renderer)
     }
 }
 
-static char *pp_lookup_transition (const char *transition)
+/*
+ * Transitions
+ *
+ * The JSON of a transition is read once per name; the ones shipped with
+ * pinpoint are compiled in as resources. Each slide showing a transition
+ * needs its own ClutterScript instance of it, and instances of slides far
+ * from the current one are handed back to a pool for the next slide using
+ * the same transition.
+ */
+
+#define TRANSITION_POOL_MAX 4 /* idle instances kept per transition */
+
+typedef struct
+{
+  ClutterScript *script;
+  ClutterActor  *json_slide;
+  ClutterActor  *foreground;
+  ClutterActor  *midground;
+  ClutterActor  *background2;
+  ClutterState  *state;
+} TransitionInstance;
+
+static GBytes *
+pp_lookup_transition (const char *transition)
 {
-  int   i;
-  char *dirs[] ={ "", PINPOINT_SRCDIR "/transitions/", PKGDATADIR, NULL};
+  char   *name, *path, *contents;
+  gsize   length;
+  GBytes *bytes;
+
+  /* a transition next to the presentation overrides a built-in one, without
+   * a presentation file that is the current directory */
+  name = g_strdup_printf ("%s.json", transition);
+  if (pp_basedir)
+    {
+      GFile *file = g_file_resolve_relative_path (pp_basedir, name);
 
-  for (i = 0; dirs[i]; i++)
+      path = g_file_get_path (file);
+      g_object_unref (file);
+      g_free (name);
+    }
+  else
+    {
+      path = name;
+    }
+  if (path && g_file_get_contents (path, &contents, &length, NULL))
     {
-      char *path = g_strdup_printf ("%s%s.json", dirs[i], transition);
-      if (g_file_test (path, G_FILE_TEST_EXISTS))
-        return path;
       g_free (path);
+      return g_bytes_new_take (contents, length);
+    }
+  g_free (path);
+
+  path = g_strdup_printf ("/org/pinpoint/transitions/%s.json", transition);
+  bytes = g_resources_lookup_data (path, G_RESOURCE_LOOKUP_FLAGS_NONE, NULL);
+  g_free (path);
+  if (bytes)
+    return bytes;
+
+  path = g_strdup_printf ("%s%s.json", PKGDATADIR, transition);
+  if (g_file_get_contents (path, &contents, &length, NULL))
+    bytes = g_bytes_new_take (contents, length);
+  g_free (path);
+
+  return bytes;
+}
+
+/* fills in the transition actors of @data from the pool, or from a new
+ * instance of the template
+ */
+static gboolean
+transition_acquire (ClutterRenderer  *renderer,
+                    PinPointPoint    *point,
+                    GError          **error)
+{
+  ClutterPointData   *data = point->data;
+  const char         *name = g_intern_string (point->transition);
+  GQueue             *pool;
+  TransitionInstance *instance;
+  GBytes             *bytes;
+
+  pool = g_hash_table_lookup (renderer->transition_pool, name);
+  instance = pool ? g_queue_pop_head (pool) : NULL;
+  if (instance)
+    {
+      data->script = instance->script;
+      data->json_slide = instance->json_slide;
+      data->foreground = instance->foreground;
+      data->midground = instance->midground;
+      data->background2 = instance->background2;
+      data->state = instance->state;
+      g_slice_free (TransitionInstance, instance);
+    }
+  else
+    {
+      if (!g_hash_table_lookup_extended (renderer->transitions, name,
+                                         NULL, (gpointer *) &bytes))
+        {
+          bytes = pp_lookup_transition (name);
+          g_hash_table_insert (renderer->transitions, (gpointer) name, bytes);
+        }
+
+      data->script = clutter_script_new ();
+      if (bytes)
+        clutter_script_load_from_data (data->script,
+                                       g_bytes_get_data (bytes, NULL),
+                                       g_bytes_get_size (bytes),
+                                       error);
+
+      data->foreground = CLUTTER_ACTOR (
+          clutter_script_get_object (data->script, "foreground"));
+      data->midground = CLUTTER_ACTOR (
+          clutter_script_get_object (data->script, "midground"));
+      data->background2 = CLUTTER_ACTOR (
+          clutter_script_get_object (data->script, "background"));
+      data->state = CLUTTER_STATE (
+          clutter_script_get_object (data->script, "state"));
+      data->json_slide = CLUTTER_ACTOR (
+          clutter_script_get_object (data->script, "actor"));
+
+      if (!data->json_slide)
+        {
+          g_clear_object (&data->script);
+          return FALSE;
+        }
+
+      clutter_actor_add_child (renderer->json_layer, data->json_slide);
+    }
+
+  data->transition = name;
+  g_signal_connect (data->state, "completed",
+                    G_CALLBACK (state_completed), point);
+  clutter_state_warp_to_state (data->state, "pre");
+
+  if (data->background2) /* parmanently steal background */
+    {
+      pp_actor_reparent (data->background, data->background2);
+    }
+
+  return TRUE;
+}
+
+/* gives the slide's own actors back and puts the instance in the pool */
+static void
+transition_release (ClutterRenderer  *renderer,
+                    ClutterPointData *data)
+{
+  TransitionInstance *instance;
+  GQueue             *pool;
+
+  if (!data->json_slide)
+    {
+      g_clear_object (&data->script);
+      return;
+    }
+
+  g_signal_handlers_disconnect_matched (data->state, G_SIGNAL_MATCH_FUNC,
+                                        0, 0, NULL, state_completed, NULL);
+
+  if (data->background &&
+      clutter_actor_get_parent (data->background) == data->background2)
+    {
+      pp_actor_reparent (data->background, renderer->background);
+      clutter_actor_set_opacity (data->background, 0);
+    }
+  if (data->foreground &&
+      clutter_actor_get_parent (data->text) == data->foreground)
+    {
+      pp_actor_reparent (data->text, renderer->foreground);
+      g_object_set (data->text,
+                    "depth",   RESTDEPTH,
+                    "scale-x", 1.0,
+                    "scale-y", 1.0,
+                    "x",       RESTX,
+                    "y",       data->rest_y,
+                    NULL);
+    }
+  if (data->shading)
+    {
+      clutter_actor_destroy (data->shading);
+      data->shading = NULL;
+    }
+
+  pool = g_hash_table_lookup (renderer->transition_pool, data->transition);
+  if (!pool)
+    {
+      pool = g_queue_new ();
+      g_hash_table_insert (renderer->transition_pool,
+                           (gpointer) data->transition, pool);
+    }
+
+  if (g_queue_get_length (pool) < TRANSITION_POOL_MAX)
+    {
+      clutter_state_warp_to_state (data->state, "pre");
+      clutter_actor_hide (data->json_slide);
+
+      instance = g_slice_new (TransitionInstance);
+      instance->script = data->script;
+      instance->json_slide = data->json_slide;
+      instance->foreground = data->foreground;
+      instance->midground = data->midground;
+      instance->background2 = data->background2;
+      instance->state = data->state;
+      g_queue_push_head (pool, instance);
+    }
+  else
+    {
+      clutter_actor_destroy (data->json_slide);
+      g_object_unref (data->script);
+    }
+
+  data->script = NULL;
+  data->json_slide = NULL;
+  data->foreground = NULL;
+  data->midground = NULL;
+  data->background2 = NULL;
+  data->state = NULL;
+  data->transition = NULL;
+}
+
+/* returns the instances of hidden slides outside the window to the pool */
+static void
+transition_recycle (ClutterRenderer *renderer)
+{
+  PinPointPoint    *point;
+  ClutterPointData *data;
+  guint             i;
+
+  for (i = 0; i < pp_slide_count (); i++)
+    {
+      if ((gint) i >= pp_slideno - pp_window_before &&
+          (gint) i <= pp_slideno + pp_window_after)
+        continue;
+
+      point = pp_slide_nth (i);
+      data = point->data;
+      if (point->ready && data && data->json_slide &&
+          !CLUTTER_ACTOR_IS_VISIBLE (data->json_slide))
+        transition_release (renderer, data);
     }
-  return NULL;
 }
 
 static void update_commandline_shading (ClutterRenderer *renderer)
@@ -1711,7 +3568,7 @@ static void update_commandline_shading (ClutterRenderer *renderer)
   float text_x,    text_y,    text_width,    text_height;
   float shading_x, shading_y, shading_width, shading_height;
 
-  point = pp_slidep->data;
+  point = pp_slide_current ();
   clutter_actor_get_size (renderer->commandline, &text_width, &text_height);
   clutter_actor_get_position (renderer->commandline, &text_x, &text_y);
   pp_get_shading_position_size (clutter_actor_get_width (renderer->stage),
@@ -1741,196 +3598,687 @@ static void update_commandline_shading (ClutterRenderer *renderer)
                      NULL);
 }
 
+/* these are called for every speaker screen update, pp_slides_time () looks
+ * the sums up instead of walking the slides
+ */
 static gfloat point_time (ClutterRenderer *renderer,
-                          PinPointPoint   *point)
+                          gint             slideno)
+{
+  return pp_slides_time (slideno, slideno + 1);
+}
+
+static gfloat total_time (ClutterRenderer *renderer,
+                          gint             start)
+{
+  return pp_slides_time (start, pp_slide_count ());
+}
+
+static gfloat slide_rel_duration (ClutterRenderer *renderer,
+                                  gint             slideno)
+{
+  return point_time (renderer, slideno) / total_time (renderer, 0);
+}
+
+static gfloat slide_rel_start (ClutterRenderer *renderer,
+                               gint             slideno)
+{
+  return pp_slides_time (0, slideno) / total_time (renderer, 0);
+}
+
+static gfloat slide_time (ClutterRenderer *renderer,
+                          gint             slideno)
+{
+  float time = point_time (renderer, slideno) /
+                     total_time (renderer, slideno);
+  float remaining_time = renderer->total_seconds -
+                           g_timer_elapsed (renderer->timer, NULL);
+  time *= remaining_time;
+  return time;
+}
+
+
+/*
+ * Speaker screen previews
+ *
+ * Previews are rendered by the cairo renderer on a worker thread into
+ * image surfaces, cached by what the slide looks like and the preview size.
+ * The main thread only copies finished surfaces into the preview textures,
+ * and leaves a preview blank until its surface is ready.
+ */
+
+#define PREVIEW_CACHE_MAX 32
+#define PREVIEW_KEY "pp-preview-key" /* on the textures, what they show */
+
+typedef struct
+{
+  ClutterRenderer *renderer;
+  PinPointPoint    point;    /* own copy, the slides can be reparsed meanwhile */
+  gint             slideno;  /* atomic, see clutter_renderer_slides_dropped () */
+  char            *key;
+  gint             width;
+  gint             height;
+  cairo_surface_t *surface;
+} PreviewJob;
+
+static gboolean preview_done (gpointer data);
+
+#define S(str) ((str) ? (str) : "")
+
+static char *
+preview_key (PinPointPoint *point,
+             gint           width,
+             gint           height)
+{
+  char *str, *key;
+
+  /* also names the thumbnails on disk, so nothing in it may differ from one
+   * run to the next */
+  str = g_strdup_printf ("%dx%d %d %d %s %s %s %s %s %d %d %s %d %s %f",
+                         width, height, point->bg_type, point->bg_scale,
+                         point->asset ? point->asset->path : "",
+                         S (point->bg), S (point->stage_color),
+                         S (point->text), S (point->font), point->position,
+                         point->text_align, S (point->text_color),
+                         point->use_markup, S (point->shading_color),
+                         point->shading_opacity);
+  key = g_compute_checksum_for_string (G_CHECKSUM_SHA1, str, -1);
+  g_free (str);
+
+  return key;
+}
+
+#undef S
+
+/* copies what the cairo renderer needs of @src, for use in another thread */
+static void
+preview_point_copy (PinPointPoint *dest,
+                    PinPointPoint *src)
+{
+  *dest = *src;
+  if (dest->asset)
+    pp_asset_ref (dest->asset);
+  dest->stage_color = g_strdup (src->stage_color);
+  dest->bg = g_strdup (src->bg);
+  dest->text = g_strdup (src->text);
+  dest->font = g_strdup (src->font);
+  dest->text_color = g_strdup (src->text_color);
+  dest->shading_color = g_strdup (src->shading_color);
+  dest->speaker_notes = NULL;
+  dest->notes_font = NULL;
+  dest->notes_font_size = NULL;
+  dest->transition = NULL;
+  dest->command = NULL;
+  dest->source = NULL;
+  dest->data = NULL;
+}
+
+static void
+preview_point_clear (PinPointPoint *point)
+{
+  if (point->asset)
+    pp_asset_unref (point->asset);
+  g_free ((char *) point->stage_color);
+  g_free ((char *) point->bg);
+  g_free ((char *) point->text);
+  g_free ((char *) point->font);
+  g_free ((char *) point->text_color);
+  g_free ((char *) point->shading_color);
+}
+
+/* may be called from any thread */
+static cairo_surface_t *
+preview_render (ClutterRenderer *renderer,
+                PinPointPoint   *point,
+                gint             width,
+                gint             height)
+{
+  cairo_surface_t *surface;
+  cairo_t         *cr;
+
+  surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, width, height);
+  cr = cairo_create (surface);
+
+  g_mutex_lock (&renderer->cairo_lock);
+  cairo_renderer_set_cr (renderer->cairo_renderer, cr, width, height);
+  cairo_renderer_render_page (renderer->cairo_renderer, point);
+  cairo_renderer_unset_cr (renderer->cairo_renderer);
+  g_mutex_unlock (&renderer->cairo_lock);
+
+  cairo_destroy (cr);
+
+  return surface;
+}
+
+static void
+preview_job_free (PreviewJob *job)
+{
+  preview_point_clear (&job->point);
+  g_free (job->key);
+  g_slice_free (PreviewJob, job);
+}
+
+static void
+preview_run (gpointer data,
+             gpointer user_data)
+{
+  PreviewJob      *job = data;
+  ClutterRenderer *renderer = job->renderer;
+
+  /* skip slides the presenter has moved away from in the meantime */
+  if (ABS (g_atomic_int_get (&job->slideno) -
+           g_atomic_int_get (&renderer->preview_current)) <= 2)
+    job->surface = preview_render (renderer, &job->point,
+                                   job->width, job->height);
+
+  g_idle_add (preview_done, job);
+}
+
+static void
+preview_paint (ClutterActor    *texture,
+               cairo_surface_t *surface)
+{
+  cairo_t *cr;
+
+  cr = clutter_cairo_texture_create (CLUTTER_CAIRO_TEXTURE (texture));
+  cairo_set_source_surface (cr, surface, 0, 0);
+  cairo_paint (cr);
+  cairo_destroy (cr);
+}
+
+static gboolean
+preview_done (gpointer data)
+{
+  PreviewJob      *job = data;
+  ClutterRenderer *renderer = job->renderer;
+  ClutterActor    *textures[] = { renderer->speaker_prev,
+                                  renderer->speaker_current,
+                                  renderer->speaker_next };
+  guint            i;
+
+  g_hash_table_remove (renderer->preview_pending, job->key);
+
+  if (job->surface)
+    {
+      g_hash_table_insert (renderer->previews, g_strdup (job->key),
+                           job->surface);
+      g_queue_push_tail (renderer->preview_order, g_strdup (job->key));
+      while (g_queue_get_length (renderer->preview_order) > PREVIEW_CACHE_MAX)
+        {
+          char *key = g_queue_pop_head (renderer->preview_order);
+
+          g_hash_table_remove (renderer->previews, key);
+          g_free (key);
+        }
+
+      for (i = 0; i < G_N_ELEMENTS (textures); i++)
+        if (!g_strcmp0 (g_object_get_data (G_OBJECT (textures[i]), PREVIEW_KEY),
+                        job->key))
+          preview_paint (textures[i], job->surface);
+    }
+  else
+    {
+      /* skipped, but the presenter may have come back to it since: forget
+       * that it is shown so that the next update requests it again */
+      for (i = 0; i < G_N_ELEMENTS (textures); i++)
+        if (!g_strcmp0 (g_object_get_data (G_OBJECT (textures[i]), PREVIEW_KEY),
+                        job->key))
+          {
+            g_object_set_data (G_OBJECT (textures[i]), PREVIEW_KEY, NULL);
+            speaker_screen_queue (renderer, SPEAKER_SLIDE);
+          }
+    }
+
+  preview_job_free (job);
+
+  return FALSE;
+}
+
+static void
+preview_request (ClutterRenderer *renderer,
+                 gint             slideno,
+                 const char      *key,
+                 gint             width,
+                 gint             height)
+{
+  PinPointPoint *point = pp_slide_nth (slideno);
+  PreviewJob    *job;
+
+  if (g_hash_table_lookup (renderer->previews, key) ||
+      g_hash_table_lookup (renderer->preview_pending, key))
+    return;
+
+  job = g_slice_new0 (PreviewJob);
+  job->renderer = renderer;
+  preview_point_copy (&job->point, point);
+  job->slideno = slideno;
+  job->key = g_strdup (key);
+  job->width = width;
+  job->height = height;
+
+  g_hash_table_insert (renderer->preview_pending, job->key, job);
+  g_thread_pool_push (renderer->preview_pool, job, NULL);
+}
+
+/* shows slide @slideno in @texture, now if it has been rendered already */
+static void
+preview_show (ClutterRenderer *renderer,
+              ClutterActor    *texture,
+              gint             slideno)
+{
+  PinPointPoint   *point = pp_slide_nth (slideno);
+  cairo_surface_t *surface;
+  gint             width, height;
+  char            *key;
+
+  if (!point)
+    {
+      g_object_set_data (G_OBJECT (texture), PREVIEW_KEY, NULL);
+      return;
+    }
+
+  width = clutter_actor_get_width (texture);
+  height = clutter_actor_get_height (texture);
+  key = preview_key (point, width, height);
+
+  if (!g_strcmp0 (g_object_get_data (G_OBJECT (texture), PREVIEW_KEY), key))
+    {
+      g_free (key);
+      return;
+    }
+  g_object_set_data_full (G_OBJECT (texture), PREVIEW_KEY, key, g_free);
+
+  surface = g_hash_table_lookup (renderer->previews, key);
+  if (surface)
+    {
+      preview_paint (texture, surface);
+    }
+  else
+    {
+      clutter_cairo_texture_clear (CLUTTER_CAIRO_TEXTURE (texture));
+      preview_request (renderer, slideno, key, width, height);
+    }
+}
+
+/*
+ * Overview
+ *
+ * A grid of all the slides, clicking one goes there. The thumbnails are
+ * rendered like the previews at the size of a cell, at most THUMB_WIDTH
+ * wide, so the grid never takes more texture memory than the stage. They
+ * are kept as PNGs in the user's cache directory, named after what the
+ * slide looks like and the modification time of its background. The grid
+ * is laid out again when the stage is resized or the slides change. It is
+ * shown at once with empty cells, that are filled in as the thumbnails are
+ * loaded or rendered by OVERVIEW_THREADS workers. Thumbnails older than
+ * THUMB_MAX_AGE, and the oldest beyond THUMB_MAX_FILES, are removed when
+ * the overview is first shown.
+ */
+
+#define OVERVIEW_THREADS 2
+#define THUMB_WIDTH      320
+#define THUMB_HEIGHT     240
+#define THUMB_MAX_AGE    (30 * 24 * 60 * 60) /* seconds */
+#define THUMB_MAX_FILES  2000
+
+typedef struct
+{
+  ClutterRenderer *renderer;
+  PinPointPoint    point;      /* own copy, see preview_point_copy () */
+  gint             slideno;
+  gint             width;
+  gint             height;
+  guint            generation; /* of the overview it is for */
+  char            *key;        /* see preview_key (), the mtime is added */
+  cairo_surface_t *surface;
+} ThumbJob;
+
+static char *
+overview_thumb_path (ThumbJob *job)
+{
+  struct stat  st;
+  char        *str, *name, *path;
+
+  str = g_strdup_printf ("%s %ld", job->key,
+                         job->point.asset &&
+                         g_stat (job->point.asset->path, &st) == 0 ?
+                         (long) st.st_mtime : 0L);
+  name = g_compute_checksum_for_string (G_CHECKSUM_SHA1, str, -1);
+  path = g_strdup_printf ("%s/%s.png", job->renderer->thumb_dir, name);
+  g_free (name);
+  g_free (str);
+
+  return path;
+}
+
+typedef struct
+{
+  char   *path;
+  gint64  mtime;
+} ThumbFile;
+
+static gint
+thumb_file_newer (gconstpointer a,
+                  gconstpointer b)
+{
+  const ThumbFile *fa = a, *fb = b;
+
+  return fa->mtime < fb->mtime ? 1 : fa->mtime > fb->mtime ? -1 : 0;
+}
+
+static void
+overview_thumb_prune (const char *dir)
+{
+  GDir        *gdir;
+  GArray      *files;
+  const char  *name;
+  struct stat  st;
+  gint64       now = g_get_real_time () / G_USEC_PER_SEC;
+  guint        i, removed = 0;
+
+  gdir = g_dir_open (dir, 0, NULL);
+  if (!gdir)
+    return;
+
+  files = g_array_new (FALSE, FALSE, sizeof (ThumbFile));
+  while ((name = g_dir_read_name (gdir)))
+    {
+      ThumbFile file;
+
+      file.path = g_build_filename (dir, name, NULL);
+      if (g_stat (file.path, &st) != 0 || !S_ISREG (st.st_mode))
+        {
+          g_free (file.path);
+          continue;
+        }
+      file.mtime = st.st_mtime;
+      g_array_append_val (files, file);
+    }
+  g_dir_close (gdir);
+
+  g_array_sort (files, thumb_file_newer);
+  for (i = 0; i < files->len; i++)
+    {
+      ThumbFile *file = &g_array_index (files, ThumbFile, i);
+
+      if (i >= THUMB_MAX_FILES || now - file->mtime > THUMB_MAX_AGE)
+        {
+          g_unlink (file->path);
+          removed++;
+        }
+      g_free (file->path);
+    }
+
+  g_debug ("removed %u of %u thumbnails", removed, files->len);
+  g_array_free (files, TRUE);
+}
+
+static gboolean overview_thumb_done (gpointer data);
+
+static void
+overview_thumb_run (gpointer data,
+                    gpointer user_data)
 {
-  GList *iter;
-  float time;
-  gboolean after_current = FALSE;
+  ThumbJob        *job = data;
+  ClutterRenderer *renderer = job->renderer;
+  char            *path, *tmp;
 
-  for (iter = pp_slides; iter && iter->data != point; iter = iter->next)
+  if (job->generation != (guint) g_atomic_int_get (&renderer->overview_generation))
+    goto out;
+
+  path = overview_thumb_path (job);
+  job->surface = cairo_image_surface_create_from_png (path);
+  if (cairo_surface_status (job->surface) != CAIRO_STATUS_SUCCESS)
     {
-      if (iter == pp_slidep)
-        after_current = TRUE;
+      cairo_surface_destroy (job->surface);
+      job->surface = preview_render (renderer, &job->point,
+                                     job->width, job->height);
+
+      /* write and rename, so a half written file is never read back */
+      tmp = g_strdup_printf ("%s.%p", path, (void *) job);
+      if (cairo_surface_write_to_png (job->surface, tmp) == CAIRO_STATUS_SUCCESS)
+        g_rename (tmp, path);
+      else
+        g_unlink (tmp);
+      g_free (tmp);
     }
+  g_free (path);
 
-  time = point->duration != 0.0 ? point->duration : 2.0;
-  /* if before current point, use new time.. if at or after current point
-     use historic time
-   */
-  if (!after_current)
-    if (point->new_duration != 0.0)
-      time = point->new_duration;
-  return time;
+out:
+  g_idle_add (overview_thumb_done, job);
 }
 
-static gfloat total_time (ClutterRenderer *renderer,
-                          GList *start)
+static gboolean
+overview_thumb_done (gpointer data)
 {
-  GList *iter;
-  gfloat total = 0;
-  if (!start)
-    start = pp_slides;
-  for (iter = start; iter; iter = iter->next)
+  ThumbJob        *job = data;
+  ClutterRenderer *renderer = job->renderer;
+
+  if (job->surface)
     {
-      total += point_time (renderer, iter->data);
+      if (renderer->overview &&
+          job->generation == (guint) renderer->overview_generation &&
+          job->slideno < (gint) renderer->overview_thumbs->len)
+        preview_paint (g_ptr_array_index (renderer->overview_thumbs,
+                                          job->slideno),
+                       job->surface);
+      cairo_surface_destroy (job->surface);
     }
-  return total;
+
+  preview_point_clear (&job->point);
+  g_free (job->key);
+  g_slice_free (ThumbJob, job);
+
+  return FALSE;
 }
 
-static gfloat slide_rel_duration (ClutterRenderer *renderer,
-                                  GList *slide)
+static gboolean
+overview_clicked (ClutterActor    *actor,
+                  ClutterEvent    *event,
+                  ClutterRenderer *renderer)
+{
+  gint slideno = GPOINTER_TO_INT (g_object_get_data (G_OBJECT (actor),
+                                                     "pp-slide"));
+
+  overview_toggle (renderer);
+  goto_slide (renderer, slideno);
+
+  return TRUE;
+}
+
+/* keeps clicks between the thumbnails from changing slides */
+static gboolean
+overview_swallow (ClutterActor *actor,
+                  ClutterEvent *event,
+                  gpointer      data)
 {
-  return point_time (renderer, slide->data) / total_time (renderer, pp_slides);
+  return TRUE;
 }
 
-static gfloat slide_rel_start (ClutterRenderer *renderer,
-                               GList *slide)
+static void
+overview_close (ClutterRenderer *renderer)
+{
+  /* jobs still queued for this overview are dropped */
+  g_atomic_int_inc (&renderer->overview_generation);
+  clutter_actor_destroy (renderer->overview);
+  renderer->overview = NULL;
+  g_ptr_array_free (renderer->overview_thumbs, TRUE);
+  renderer->overview_thumbs = NULL;
+}
+
+static void
+overview_open (ClutterRenderer *renderer)
 {
-  GList *iter;
-  float time = 0;
+  ClutterActor *thumb;
+  ThumbJob     *job;
+  float         stage_width, stage_height, cell_width, cell_height, scale;
+  gint          thumb_width, thumb_height;
+  guint         n, i, columns;
+
+  n = pp_slide_count ();
+  if (!n)
+    return;
 
-  for (iter = slide ->prev; iter; iter = iter->prev)
+  if (!renderer->thumb_pool)
     {
-      time += point_time (renderer, iter->data);
+      renderer->thumb_dir = g_build_filename (g_get_user_cache_dir (),
+                                              "pinpoint", "thumbnails", NULL);
+      g_mkdir_with_parents (renderer->thumb_dir, 0700);
+      overview_thumb_prune (renderer->thumb_dir);
+      renderer->thumb_pool = g_thread_pool_new (overview_thumb_run, NULL,
+                                                OVERVIEW_THREADS, FALSE, NULL);
     }
 
-  time = time / total_time (renderer, pp_slides);
-  return time;
+  clutter_actor_get_size (renderer->stage, &stage_width, &stage_height);
+
+  /* the fewest columns that fit all the slides on the stage */
+  for (columns = 1; columns < n; columns++)
+    {
+      cell_width = stage_width / columns;
+      cell_height = cell_width * THUMB_HEIGHT / THUMB_WIDTH;
+      if (cell_height * ((n + columns - 1) / columns) <= stage_height)
+        break;
+    }
+  cell_width = stage_width / columns;
+  cell_height = cell_width * THUMB_HEIGHT / THUMB_WIDTH;
+
+  /* big decks get small cells, only render what they show */
+  thumb_width = CLAMP ((gint) (cell_width * 0.9), 1, THUMB_WIDTH);
+  thumb_height = MAX (thumb_width * THUMB_HEIGHT / THUMB_WIDTH, 1);
+  scale = cell_width * 0.9 / thumb_width;
+
+  renderer->overview = pp_rectangle_new_with_color (&black);
+  clutter_actor_set_size (renderer->overview, stage_width, stage_height);
+  clutter_actor_set_reactive (renderer->overview, TRUE);
+  g_signal_connect (renderer->overview, "button-press-event",
+                    G_CALLBACK (overview_swallow), NULL);
+  clutter_actor_add_child (renderer->stage, renderer->overview);
+  renderer->overview_thumbs = g_ptr_array_sized_new (n);
+
+  for (i = 0; i < n; i++)
+    {
+      thumb = clutter_cairo_texture_new (thumb_width, thumb_height);
+      clutter_actor_set_background_color (thumb,
+                                          (gint) i == pp_slideno ? &white : &gray);
+      clutter_actor_set_scale (thumb, scale, scale);
+      clutter_actor_set_position (thumb,
+                                  (i % columns) * cell_width + cell_width * 0.05,
+                                  (i / columns) * cell_height + cell_height * 0.05);
+      clutter_actor_set_reactive (thumb, TRUE);
+      g_object_set_data (G_OBJECT (thumb), "pp-slide", GINT_TO_POINTER (i));
+      g_signal_connect (thumb, "button-press-event",
+                        G_CALLBACK (overview_clicked), renderer);
+      clutter_actor_add_child (renderer->overview, thumb);
+      g_ptr_array_add (renderer->overview_thumbs, thumb);
+
+      job = g_slice_new0 (ThumbJob);
+      job->renderer = renderer;
+      preview_point_copy (&job->point, pp_slide_nth (i));
+      job->slideno = i;
+      job->width = thumb_width;
+      job->height = thumb_height;
+      job->generation = renderer->overview_generation;
+      job->key = preview_key (&job->point, thumb_width, thumb_height);
+      g_thread_pool_push (renderer->thumb_pool, job, NULL);
+    }
 }
 
-static gfloat slide_time (ClutterRenderer *renderer,
-                          GList *slide)
+static void
+overview_toggle (ClutterRenderer *renderer)
 {
-  float time = point_time (renderer, slide->data) /
-                     total_time (renderer, slide);
-  float remaining_time = renderer->total_seconds -
-                           g_timer_elapsed (renderer->timer, NULL);
-  time *= remaining_time;
-  return time;
+  if (renderer->overview)
+    overview_close (renderer);
+  else
+    overview_open (renderer);
 }
 
-
-static gboolean update_speaker_screen (ClutterRenderer *renderer)
+/* lays the grid out again for the current stage size and slides, if it is
+ * shown */
+static void
+overview_update (ClutterRenderer *renderer)
 {
-  PinPointPoint *point;
+  if (!renderer->overview)
+    return;
 
-  if (!pp_slidep)
-    return FALSE;
+  overview_close (renderer);
+  overview_open (renderer);
+}
 
-  point = pp_slidep->data;
-  static gboolean is_updated = TRUE;
-  static float current_slide_time = 0.0;
-  static float current_slide_duration = 0.0;
-  static GList *current_slide = NULL;
-  float nh, nw;
+static void update_speaker_screen (ClutterRenderer *renderer)
+{
+  PinPointPoint *point;
+  guint          dirty = renderer->speaker_dirty;
+  float          nh, nw;
 
-  /* Skip this update since the previous one isn't finished */
-  if (!is_updated)
-    return TRUE;
+  renderer->speaker_dirty = 0;
 
-  is_updated = FALSE;
+  point = pp_slide_current ();
+  if (!point || !renderer->speaker_mode)
+    return;
 
-  if (renderer->reset)
-    {
-      current_slide = NULL;
-      current_slide_duration = 0.0;
-      current_slide_time = 0.0;
-      renderer->reset = FALSE;
-    }
+  nw = clutter_actor_get_width (renderer->speaker_screen) + 1;
+  nh = clutter_actor_get_height (renderer->speaker_screen);
 
+  if (dirty & SPEAKER_TIME)
     {
-      static float current_slide_prev_time = 0.0;
       float warn_time = SLIDE_WARN_TIME;
-      float diff = g_timer_elapsed (renderer->timer, NULL) - current_slide_prev_time;
-
-      if (current_slide != pp_slidep)
-        {
-          current_slide_time = 0;
-          current_slide = pp_slidep;
-          current_slide_duration = slide_time (renderer, pp_slidep);
-        }
+      float slide_elapsed = g_timer_elapsed (renderer->timer, NULL) -
+                            renderer->slide_start_time;
 
       /* if 33% of the slide is longer than the seconds based threshold, use
          the percentage
        */
-      if ((warn_time <= current_slide_duration * SLIDE_WARN_THRESHOLD))
-        warn_time =     current_slide_duration * SLIDE_WARN_THRESHOLD;
+      if ((warn_time <= renderer->slide_duration * SLIDE_WARN_THRESHOLD))
+        warn_time =     renderer->slide_duration * SLIDE_WARN_THRESHOLD;
 
-      current_slide_time += diff;
-      if (current_slide_time >= current_slide_duration)
+      if (slide_elapsed >= renderer->slide_duration)
         {
-          if (renderer->autoadvance)
-            {
-              current_slide_time = 0;
-              next_slide (renderer);
-            }
-
-
-          if (renderer->speaker_slide_prog_warning)
-            pp_actor_animate (renderer->speaker_slide_prog_warning,
-                              CLUTTER_LINEAR, 500,
-                              "opacity", OPACITY_OVER_TIME,
-                              NULL);
+          pp_actor_animate (renderer->speaker_slide_prog_warning,
+                            CLUTTER_LINEAR, 500,
+                            "opacity", OPACITY_OVER_TIME,
+                            NULL);
         }
-
-
-      else if ((current_slide_duration - current_slide_time < warn_time))
+      else if ((renderer->slide_duration - slide_elapsed < warn_time))
         {
-          if (renderer->speaker_slide_prog_warning)
-            pp_actor_animate (renderer->speaker_slide_prog_warning,
-                              CLUTTER_LINEAR, 500,
-                              "opacity", OPACITY_PAST_THRESHOLD,
-                              NULL);
+          pp_actor_animate (renderer->speaker_slide_prog_warning,
+                            CLUTTER_LINEAR, 500,
+                            "opacity", OPACITY_PAST_THRESHOLD,
+                            NULL);
         }
       else
         {
-          if (renderer->speaker_slide_prog_warning)
-            pp_actor_animate (renderer->speaker_slide_prog_warning,
-                              CLUTTER_LINEAR, 50,
-                              "opacity", OPACITY_OK,
-                              NULL);
+          pp_actor_animate (renderer->speaker_slide_prog_warning,
+                            CLUTTER_LINEAR, 50,
+                            "opacity", OPACITY_OK,
+                            NULL);
         }
-
-      current_slide_prev_time = g_timer_elapsed (renderer->timer, NULL);
     }
 
-  if (!renderer->speaker_mode)
-    goto out;
+  if (dirty & SPEAKER_TIME)
+  { /* should draw rectangles representing progress instead... */
+    char text[32];
+    int  time;
 
-  nw = clutter_actor_get_width (renderer->speaker_screen) + 1;
-  nh = clutter_actor_get_height (renderer->speaker_screen);
+    time = renderer->total_seconds -
+                    g_timer_elapsed (renderer->timer, NULL) + 0.5;
 
-  { /* should draw rectangles representing progress instead... */
-    GString *str = g_string_new ("");
-    int i;
-    GList *iter;
-    for (iter = pp_slides, i=0; iter && iter != pp_slidep;
-         iter = iter->next, i++);
-
-    {
-      int time;
-      time = renderer->total_seconds -
-                      g_timer_elapsed (renderer->timer, NULL) + 0.5;
-
-      if (time <= -60)
-        g_string_printf (str, "%imin", time/60);
-      else if (time <= 10)
-        g_string_printf (str, "%is", time);
-      else if (time <= 60)
-        {
-          time = ((time + 4)/ 5) * 5;
-          g_string_printf (str, "%is", time);
-        }
-      else
-        g_string_printf (str, "%i%smin", time / 60, (time % 60 > 30) ? "½":"");
+    if (time <= -60)
+      g_snprintf (text, sizeof (text), "%imin", time/60);
+    else if (time <= 10)
+      g_snprintf (text, sizeof (text), "%is", time);
+    else if (time <= 60)
+      {
+        time = ((time + 4)/ 5) * 5;
+        g_snprintf (text, sizeof (text), "%is", time);
+      }
+    else
+      g_snprintf (text, sizeof (text), "%i%smin", time / 60,
+                  (time % 60 > 30) ? "½":"");
 
-      clutter_text_set_text (CLUTTER_TEXT (renderer->speaker_time_remaining),
-                             str->str);
-    }
-    g_string_free (str, TRUE);
+    clutter_text_set_text (CLUTTER_TEXT (renderer->speaker_time_remaining),
+                           text);
   }
 
+  if (dirty & SPEAKER_LAYOUT)
   {
 #define append_ltr(a,b) \
   clutter_actor_set_x (b, clutter_actor_get_x (a) + clutter_actor_get_width (a) + 20)
@@ -1951,50 +4299,53 @@ static gboolean update_speaker_screen (ClutterRenderer *renderer)
     float y = clutter_actor_get_height (renderer->speaker_screen) - height;
     float elapsed_part = g_timer_elapsed (renderer->timer, NULL) / renderer->total_seconds;
 
-    clutter_actor_set_height (renderer->speaker_prog_bg, height);
-    clutter_actor_set_height (renderer->speaker_prog_slide, height * 0.7);
-    clutter_actor_set_height (renderer->speaker_prog_time, height * 0.84);
-    clutter_actor_set_size   (renderer->speaker_slide_prog_warning,
-                              nw, height * 1.0);
-    clutter_actor_set_y (renderer->speaker_prog_bg, y);
-    clutter_actor_set_y (renderer->speaker_prog_slide, y + height * 0.05);
-    clutter_actor_set_y (renderer->speaker_prog_time, y);
-
-    clutter_actor_set_y (renderer->speaker_slide_prog_warning, y - height * 0.1);
-    /*
-    clutter_actor_set_size   (renderer->speaker_slide_prog_warning,
-                              nw, nh);
-    clutter_actor_set_y (renderer->speaker_slide_prog_warning, 0);*/
-
-    clutter_actor_set_x (renderer->speaker_buttons_group, 0);
-    clutter_actor_set_y (renderer->speaker_buttons_group, 0);
-
-    clutter_actor_set_width (renderer->speaker_prog_bg, nw);
-
+    if (dirty & SPEAKER_LAYOUT)
+      {
+        clutter_actor_set_height (renderer->speaker_prog_bg, height);
+        clutter_actor_set_height (renderer->speaker_prog_slide, height * 0.7);
+        clutter_actor_set_height (renderer->speaker_prog_time, height * 0.84);
+        clutter_actor_set_size   (renderer->speaker_slide_prog_warning,
+                                  nw, height * 1.0);
+        clutter_actor_set_y (renderer->speaker_prog_bg, y);
+        clutter_actor_set_y (renderer->speaker_prog_slide, y + height * 0.05);
+        clutter_actor_set_y (renderer->speaker_prog_time, y);
 
-    clutter_actor_set_position (renderer->speaker_time_remaining,
-       nw - clutter_actor_get_width (renderer->speaker_time_remaining),
-       nh - clutter_actor_get_height (renderer->speaker_time_remaining) - 4);
+        clutter_actor_set_y (renderer->speaker_slide_prog_warning, y - height * 0.1);
 
-    clutter_actor_set_width (renderer->speaker_prog_slide,
-                             nw * slide_rel_duration (renderer, pp_slidep));
-    clutter_actor_set_x (renderer->speaker_prog_slide,
-                         nw * slide_rel_start (renderer, pp_slidep));
+        clutter_actor_set_x (renderer->speaker_buttons_group, 0);
+        clutter_actor_set_y (renderer->speaker_buttons_group, 0);
 
-    clutter_actor_set_x (renderer->speaker_prog_time, nw * elapsed_part);
+        clutter_actor_set_width (renderer->speaker_prog_bg, nw);
+      }
 
-    clutter_actor_set_width (renderer->speaker_prog_time, nw * (1.0-elapsed_part));
+    if (dirty & (SPEAKER_TIME | SPEAKER_LAYOUT))
+      {
+        clutter_actor_set_position (renderer->speaker_time_remaining,
+           nw - clutter_actor_get_width (renderer->speaker_time_remaining),
+           nh - clutter_actor_get_height (renderer->speaker_time_remaining) - 4);
 
+        clutter_actor_set_x (renderer->speaker_prog_time, nw * elapsed_part);
+        clutter_actor_set_width (renderer->speaker_prog_time, nw * (1.0-elapsed_part));
+      }
 
-    elapsed_part = current_slide_time / current_slide_duration;
+    if (dirty & (SPEAKER_SLIDE | SPEAKER_LAYOUT))
+      {
+        clutter_actor_set_width (renderer->speaker_prog_slide,
+                                 nw * slide_rel_duration (renderer, pp_slideno));
+        clutter_actor_set_x (renderer->speaker_prog_slide,
+                             nw * slide_rel_start (renderer, pp_slideno));
+      }
   }
 
+  if (!(dirty & (SPEAKER_SLIDE | SPEAKER_LAYOUT)))
+    return;
+
   // if first slide, do not show "previous"
-  if (!pp_slidep->prev) clutter_actor_hide(renderer->speaker_prev);
+  if (!pp_slide_nth (pp_slideno - 1)) clutter_actor_hide(renderer->speaker_prev);
   else clutter_actor_show(renderer->speaker_prev);
 
   // same for last slide
-  if (!pp_slidep->next) clutter_actor_hide(renderer->speaker_next);
+  if (!pp_slide_nth (pp_slideno + 1)) clutter_actor_hide(renderer->speaker_next);
   else clutter_actor_show(renderer->speaker_next);
 
 
@@ -2010,53 +4361,26 @@ static gboolean update_speaker_screen (ClutterRenderer *renderer)
     clutter_actor_set_height(renderer->speaker_preview_bar, nh);
   }
 
-  {
-    static GList *current_slide = NULL;
-    if (current_slide != pp_slidep)
-      {
-        cairo_t *cr;
-
-        /*************/
-        cr = clutter_cairo_texture_create (CLUTTER_CAIRO_TEXTURE (renderer->speaker_prev));
-        cairo_renderer_set_cr (renderer->cairo_renderer,
-                               cr, clutter_actor_get_width (renderer->speaker_prev),
-                               clutter_actor_get_height (renderer->speaker_prev));
-        if (pp_slidep->prev)
-          cairo_renderer_render_page (renderer->cairo_renderer,
-                                      pp_slidep->prev->data);
-        else
-          cairo_renderer_render_page (renderer->cairo_renderer,
-                                      NULL);
-        cairo_renderer_unset_cr (renderer->cairo_renderer);
-        cairo_destroy (cr);
-
-        /*************/
-        cr = clutter_cairo_texture_create (CLUTTER_CAIRO_TEXTURE (renderer->speaker_current));
-        cairo_renderer_set_cr (renderer->cairo_renderer,
-                               cr, clutter_actor_get_width (renderer->speaker_current),
-                               clutter_actor_get_height (renderer->speaker_current));
-        cairo_renderer_render_page (renderer->cairo_renderer,
-                                    pp_slidep->data);
-        cairo_renderer_unset_cr (renderer->cairo_renderer);
-        cairo_destroy (cr);
-
-        /*************/
-        cr = clutter_cairo_texture_create (CLUTTER_CAIRO_TEXTURE (renderer->speaker_next));
-        cairo_renderer_set_cr (renderer->cairo_renderer,
-                               cr, clutter_actor_get_width (renderer->speaker_next),
-                               clutter_actor_get_height (renderer->speaker_next));
-        if (pp_slidep->next)
-          cairo_renderer_render_page (renderer->cairo_renderer,
-                                      pp_slidep->next->data);
-        else
-          cairo_renderer_render_page (renderer->cairo_renderer,
-                                      NULL);
-        cairo_renderer_unset_cr (renderer->cairo_renderer);
-        cairo_destroy (cr);
-        /*************/
-        current_slide = pp_slidep;
+  if (dirty & SPEAKER_SLIDE)
+    {
+      g_atomic_int_set (&renderer->preview_current, pp_slideno);
+
+      /* the current one first, the worker renders in that order */
+      preview_show (renderer, renderer->speaker_current, pp_slideno);
+      preview_show (renderer, renderer->speaker_next, pp_slideno + 1);
+      preview_show (renderer, renderer->speaker_prev, pp_slideno - 1);
+      if (pp_slide_nth (pp_slideno + 2))
+        {
+          /* so that moving forward finds the next preview ready */
+          char *key = preview_key (pp_slide_nth (pp_slideno + 2),
+                                   clutter_actor_get_width (renderer->speaker_next),
+                                   clutter_actor_get_height (renderer->speaker_next));
+          preview_request (renderer, pp_slideno + 2, key,
+                           clutter_actor_get_width (renderer->speaker_next),
+                           clutter_actor_get_height (renderer->speaker_next));
+          g_free (key);
+        }
     }
-  }
 
   clutter_actor_set_position (renderer->speaker_prev,
                               nw * 0.0,
@@ -2081,15 +4405,16 @@ static gboolean update_speaker_screen (ClutterRenderer *renderer)
 
     // handle notes-font-size=auto:
     float text_scale;
+    char *font_name;
     if (g_strcmp0(point->notes_font_size, "auto")==0) {
     	text_scale = (nh-(clutter_actor_get_height(CLUTTER_ACTOR(renderer->speaker_buttons_group))+40.0))/clutter_actor_get_width(renderer->speaker_notes);
-        clutter_text_set_font_name(CLUTTER_TEXT (renderer->speaker_notes),
-        					   g_strconcat(point->notes_font, spc_text, "20px", NULL));
+            font_name = g_strconcat(point->notes_font, spc_text, "20px", NULL);
     } else {
     	text_scale = 1.0;
-        clutter_text_set_font_name(CLUTTER_TEXT (renderer->speaker_notes),
-        					   g_strconcat(point->notes_font, spc_text, point->notes_font_size, NULL));
+        font_name = g_strconcat(point->notes_font, spc_text, point->notes_font_size, NULL);
     }
+    clutter_text_set_font_name(CLUTTER_TEXT (renderer->speaker_notes), font_name);
+    g_free (font_name);
     g_object_set (renderer->speaker_notes,
 				  "scale-x", text_scale,
 				  "scale-y", text_scale,
@@ -2098,12 +4423,71 @@ static gboolean update_speaker_screen (ClutterRenderer *renderer)
   }
   else
     clutter_text_set_text (CLUTTER_TEXT (renderer->speaker_notes), "");
-out:
-  is_updated = TRUE;
+}
+
+static gboolean
+speaker_screen_idle (gpointer data)
+{
+  ClutterRenderer *renderer = data;
+
+  renderer->speaker_idle = 0;
+  update_speaker_screen (renderer);
+
+  return FALSE;
+}
+
+/* marks @dirty parts of the speaker screen for the next update */
+static void
+speaker_screen_queue (ClutterRenderer *renderer,
+                      guint            dirty)
+{
+  renderer->speaker_dirty |= dirty;
+
+  if (renderer->speaker_mode && !renderer->speaker_idle)
+    renderer->speaker_idle = g_idle_add (speaker_screen_idle, renderer);
+}
+
+static gboolean
+speaker_screen_tick (gpointer data)
+{
+  speaker_screen_queue (data, SPEAKER_TIME);
 
   return TRUE;
 }
 
+static gboolean
+autoadvance_timeout (gpointer data)
+{
+  ClutterRenderer *renderer = data;
+
+  renderer->autoadvance_id = 0;
+  next_slide (renderer);
+
+  return FALSE;
+}
+
+/* (re)schedules moving on once the current slide's time is up */
+static void
+autoadvance_schedule (ClutterRenderer *renderer)
+{
+  gdouble remaining;
+
+  if (renderer->autoadvance_id)
+    {
+      g_source_remove (renderer->autoadvance_id);
+      renderer->autoadvance_id = 0;
+    }
+
+  if (!renderer->autoadvance || renderer->timer_paused || !pp_slide_current ())
+    return;
+
+  remaining = renderer->slide_duration -
+              (g_timer_elapsed (renderer->timer, NULL) -
+               renderer->slide_start_time);
+  renderer->autoadvance_id = g_timeout_add (MAX (remaining, 0.0) * 1000,
+                                            autoadvance_timeout, renderer);
+}
+
 static void
 show_slide (ClutterRenderer *renderer, gboolean backwards)
 {
@@ -2111,12 +4495,24 @@ show_slide (ClutterRenderer *renderer, gboolean backwards)
   ClutterPointData *data;
   ClutterColor      color;
 
-  if (!pp_slidep)
+  point = pp_slide_current ();
+  if (!point)
     return;
 
+  renderer->slide_requested = renderer->input_time ? renderer->input_time
+                                                   : g_get_monotonic_time ();
+  renderer->input_time = 0;
+
+  pp_slides_window_update ();
+  decode_prefetch (renderer);
+#ifdef USE_CLUTTER_GST
+  video_prefetch (renderer);
+#endif
+  transition_recycle (renderer);
   renderer->slide_start_time = g_timer_elapsed (renderer->timer, NULL);
+  renderer->slide_duration = slide_time (renderer, pp_slideno);
+  autoadvance_schedule (renderer);
 
-  point = pp_slidep->data;
   data = point->data;
 
   if (point->stage_color)
@@ -2134,10 +4530,9 @@ show_slide (ClutterRenderer *renderer, gboolean backwards)
         {
           gst_element_set_state (data->pipeline, GST_STATE_PLAYING);
         }
-      else if (CLUTTER_GST_IS_VIDEO_TEXTURE (data->background))
+      else if (data->video && data->video->texture)
         {
-          clutter_media_set_progress (CLUTTER_MEDIA (data->background), 0.0);
-          clutter_media_set_playing (CLUTTER_MEDIA (data->background), TRUE);
+          video_pipe_play (data->video, point);
         }
       else
 #endif
@@ -2235,6 +4630,7 @@ show_slide (ClutterRenderer *renderer, gboolean backwards)
                            CLUTTER_LINEAR, 1000,
                            "opacity", 0xff,
                            NULL);
+      slide_animation_start (point, 1000);
     }
   else
     {
@@ -2252,32 +4648,13 @@ show_slide (ClutterRenderer *renderer, gboolean backwards)
                          CLUTTER_LINEAR, 500,
                          "opacity",      0,
                          NULL);
-      if (!data->script)
+      if (!data->json_slide &&
+          !transition_acquire (renderer, point, &error))
         {
-          char *path = pp_lookup_transition (point->transition);
-          data->script = clutter_script_new ();
-          clutter_script_load_from_file (data->script, path, &error);
-          g_free (path);
-          data->foreground = CLUTTER_ACTOR (
-              clutter_script_get_object (data->script, "foreground"));
-          data->midground = CLUTTER_ACTOR (
-              clutter_script_get_object (data->script, "midground"));
-          data->background2 = CLUTTER_ACTOR (
-              clutter_script_get_object (data->script, "background"));
-          data->state = CLUTTER_STATE (
-              clutter_script_get_object (data->script, "state"));
-          data->json_slide = CLUTTER_ACTOR (
-              clutter_script_get_object (data->script, "actor"));
-
-          clutter_actor_add_child (renderer->json_layer, data->json_slide);
-          g_signal_connect (data->state, "completed",
-                            G_CALLBACK (state_completed), point);
-          clutter_state_warp_to_state (data->state, "pre");
-
-          if (data->background2) /* parmanently steal background */
-            {
-              pp_actor_reparent (data->background, data->background2);
-            }
+          g_warning ("failed to load transition %s %s\n",
+                     point->transition, error?error->message:"");
+          g_clear_error (&error);
+          return;
         }
 
       clutter_actor_set_size (data->json_slide,
@@ -2292,13 +4669,6 @@ show_slide (ClutterRenderer *renderer, gboolean backwards)
                               clutter_actor_get_width (renderer->stage),
                               clutter_actor_get_height (renderer->stage));
 
-      if (!data->json_slide)
-        {
-          g_warning ("failed to load transition %s %s\n",
-                     point->transition, error?error->message:"");
-          return;
-        }
-
       if (data->foreground)
         {
           pp_actor_reparent (data->text, data->foreground);
@@ -2375,6 +4745,9 @@ show_slide (ClutterRenderer *renderer, gboolean backwards)
 
       clutter_actor_show (data->json_slide);
       clutter_state_set_state (data->state, "show");
+      slide_animation_start (point,
+                             clutter_state_get_duration (data->state,
+                                                         NULL, "show"));
     }
 
   /* render potentially executed commands */
@@ -2415,19 +4788,134 @@ show_slide (ClutterRenderer *renderer, gboolean backwards)
    update_commandline_shading (renderer);
   }
 
-  if (renderer->speaker_mode)
+  speaker_screen_queue (renderer, SPEAKER_ALL);
+}
+
+/* Puts the current slide where show_slide () would for the new stage size,
+ * without starting its animations or media again.
+ */
+static void
+relayout_slide (ClutterRenderer *renderer)
+{
+  PinPointPoint    *point;
+  ClutterPointData *data;
+  ClutterActor     *shading;
+  float             stage_width, stage_height;
+  float             text_x, text_y, text_width, text_height, text_scale;
+  float             shading_x, shading_y, shading_width, shading_height;
+
+  point = pp_slide_current ();
+  if (!point || !point->data)
+    return;
+  data = point->data;
+
+  clutter_actor_get_size (renderer->stage, &stage_width, &stage_height);
+
+  if (data->background)
+    pp_clutter_render_adjust_background (renderer, point);
+
+  /* a bigger stage may need bigger background decodes */
+  decode_prefetch (renderer);
+#ifdef USE_CLUTTER_GST
+  if (data->video && data->video->texture && video_pipe_scale (data->video))
+    video_pipe_flush (data->video);
+#endif
+
+  if (point->transition)
+    {
+      if (!data->json_slide)
+        return;
+
+      clutter_actor_set_size (data->json_slide, stage_width, stage_height);
+      clutter_actor_set_size (data->foreground, stage_width, stage_height);
+      clutter_actor_set_size (data->background2, stage_width, stage_height);
+      if (data->shading)
+        clutter_actor_set_size (data->midground, stage_width, stage_height);
+      shading = data->shading;
+    }
+  else
+    {
+      shading = point->text && *point->text ? renderer->shading : NULL;
+    }
+
+  if (data->text && (point->transition || (point->text && *point->text)))
     {
-      update_speaker_screen (renderer);
+      clutter_actor_get_size (data->text, &text_width, &text_height);
+      pp_get_text_position_scale (point, stage_width, stage_height,
+                                  text_width, text_height,
+                                  &text_x, &text_y, &text_scale);
+      g_object_set (data->text,
+                    "scale-x", text_scale,
+                    "scale-y", text_scale,
+                    "x",       text_x,
+                    "y",       text_y,
+                    NULL);
+
+      if (shading)
+        {
+          pp_get_shading_position_size (stage_width, stage_height,
+                                        text_x, text_y,
+                                        text_width, text_height,
+                                        text_scale,
+                                        &shading_x, &shading_y,
+                                        &shading_width, &shading_height);
+          g_object_set (shading,
+                        "x",      shading_x,
+                        "y",      shading_y,
+                        "width",  shading_width,
+                        "height", shading_height,
+                        NULL);
+        }
     }
+
+  clutter_actor_get_size (renderer->commandline, &text_width, &text_height);
+  if (point->position == CLUTTER_GRAVITY_SOUTH ||
+      point->position == CLUTTER_GRAVITY_SOUTH_WEST)
+    text_y = stage_height * 0.05;
+  else
+    text_y = stage_height * 0.95 - text_height;
+  g_object_set (renderer->commandline,
+                "x", stage_width * 0.05,
+                "y", text_y,
+                NULL);
+  update_commandline_shading (renderer);
+
+  speaker_screen_queue (renderer, SPEAKER_ALL);
+}
+
+static gboolean
+relayout (gpointer data)
+{
+  ClutterRenderer *renderer = data;
+
+  renderer->relayout_id = 0;
+  relayout_slide (renderer);
+
+  if (renderer->overview &&
+      (clutter_actor_get_width (renderer->overview) !=
+       clutter_actor_get_width (renderer->stage) ||
+       clutter_actor_get_height (renderer->overview) !=
+       clutter_actor_get_height (renderer->stage)))
+    overview_update (renderer);
+
+  return FALSE;
 }
 
+/* Both stages notify width and height separately, and dragging a window
+ * edge notifies continuously; relayout at most once per frame.
+ */
 static void
 stage_resized (ClutterActor    *actor,
                GParamSpec      *pspec,
                ClutterRenderer *renderer)
 {
-  show_slide (renderer, FALSE); /* redisplay the current slide */
-  update_speaker_screen (renderer);
+  if (renderer->relayout_id)
+    return;
+
+  renderer->relayout_id =
+    clutter_threads_add_repaint_func_full (CLUTTER_REPAINT_FLAGS_PRE_PAINT |
+                                           CLUTTER_REPAINT_FLAGS_QUEUE_REDRAW_ON_ADD,
+                                           relayout, renderer, NULL);
 }
 
 static guint reload_tag = 0;
@@ -2441,10 +4929,10 @@ reload (gpointer data)
   if (!g_file_get_contents (renderer->path, &text, NULL, NULL))
     g_error ("failed to load slides from %s\n", renderer->path);
 
-  renderer->rest_y = STARTPOS;
   pp_parse_slides (PINPOINT_RENDERER (renderer), text);
   g_free (text);
   show_slide(renderer, FALSE);
+  overview_update (renderer);
   reload_tag = 0;
   return FALSE;
 }
@@ -2462,6 +4950,138 @@ file_changed (GFileMonitor      *monitor,
   reload_tag = g_timeout_add (200, reload, renderer);
 }
 
+static gboolean
+stream_read (GIOChannel      *channel,
+             GIOCondition     condition,
+             ClutterRenderer *renderer)
+{
+  GString   *text = g_string_new ("");
+  GIOStatus  status;
+  gboolean   eof;
+  gboolean   empty = pp_slide_count () == 0;
+  guint      count = pp_slide_count ();
+  char       buf[4096];
+  gsize      len;
+
+  do
+    {
+      status = g_io_channel_read_chars (channel, buf, sizeof (buf), &len, NULL);
+      g_string_append_len (text, buf, len);
+    }
+  while (status == G_IO_STATUS_NORMAL);
+
+  eof = status != G_IO_STATUS_AGAIN;
+  if (pp_stream_append (PINPOINT_RENDERER (renderer),
+                        text->str, text->len, eof) && empty)
+    {
+      /* the header has been read by now */
+      renderer->total_seconds = point_defaults->duration * 60;
+      goto_slide (renderer, 0);
+    }
+  if (pp_slide_count () != count)
+    overview_update (renderer);
+  g_string_free (text, TRUE);
+
+  if (eof)
+    g_io_channel_unref (channel);
+  return !eof;
+}
+
+/* read the presentation from stdin, or from the path given, as it is written */
+static void
+stream_open (ClutterRenderer *renderer)
+{
+  GIOChannel *channel;
+  GError     *error = NULL;
+
+  if (!renderer->path || g_str_equal (renderer->path, "-"))
+    channel = g_io_channel_unix_new (0);
+  else
+    channel = g_io_channel_new_file (renderer->path, "r", &error);
+
+  if (!channel)
+    {
+      g_warning ("could not open %s: %s", renderer->path, error->message);
+      g_clear_error (&error);
+      return;
+    }
+
+  g_io_channel_set_encoding (channel, NULL, NULL);
+  g_io_channel_set_flags (channel, G_IO_FLAG_NONBLOCK, NULL);
+  g_io_add_watch (channel, G_IO_IN | G_IO_HUP | G_IO_ERR,
+                  (GIOFunc) stream_read, renderer);
+}
+
+/* Destroys the decode jobs and video pipelines of assets no slide uses any
+ * more, unless they are busy; the next sweep gets those.
+ */
+static void
+clutter_renderer_release_assets (PinPointRenderer *pp_renderer)
+{
+  ClutterRenderer *renderer = CLUTTER_RENDERER (pp_renderer);
+  GHashTableIter   iter;
+  DecodeJob       *job;
+#ifdef USE_CLUTTER_GST
+  VideoPipe       *pipe;
+#endif
+
+  g_hash_table_iter_init (&iter, renderer->decode_jobs);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &job))
+    {
+      if (job->asset->used || job->users || job->state == DECODE_QUEUED)
+        continue;
+      if (job->texture)
+        texture_evict (job);
+      g_hash_table_iter_remove (&iter);
+    }
+
+#ifdef USE_CLUTTER_GST
+  g_hash_table_iter_init (&iter, renderer->videos);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &pipe))
+    {
+      if (pipe->asset->used || pipe->clones || pipe->playing)
+        continue;
+      video_pipe_close (pipe);
+      g_hash_table_iter_remove (&iter);
+    }
+#endif
+
+  /* the previews hold on to their own */
+  g_mutex_lock (&renderer->cairo_lock);
+  if (renderer->cairo_renderer->release_assets)
+    renderer->cairo_renderer->release_assets (renderer->cairo_renderer);
+  g_mutex_unlock (&renderer->cairo_lock);
+}
+
+/* Streaming dropped the first @n slides: what is kept by slide number moves
+ * down with the slides.
+ */
+static void
+clutter_renderer_slides_dropped (PinPointRenderer *pp_renderer,
+                                 guint             n)
+{
+  ClutterRenderer *renderer = CLUTTER_RENDERER (pp_renderer);
+  GHashTableIter   iter;
+  DecodeJob       *job;
+  PreviewJob      *preview;
+
+  g_atomic_int_add (&renderer->decode_current, - (gint) n);
+  renderer->decode_shown -= n;
+  g_hash_table_iter_init (&iter, renderer->decode_jobs);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &job))
+    g_atomic_int_add (&job->slideno, - (gint) n);
+
+  g_atomic_int_add (&renderer->preview_current, - (gint) n);
+  g_hash_table_iter_init (&iter, renderer->preview_pending);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &preview))
+    g_atomic_int_add (&preview->slideno, - (gint) n);
+
+  /* the grid is laid out by slide number */
+  overview_update (renderer);
+
+  speaker_screen_queue (renderer, SPEAKER_ALL);
+}
+
 static ClutterRenderer clutter_renderer_vtable =
 {
   .renderer =
@@ -2471,7 +5091,9 @@ static ClutterRenderer clutter_renderer_vtable =
       .finalize = clutter_renderer_finalize,
       .make_point = clutter_renderer_make_point,
       .allocate_data = clutter_renderer_allocate_data,
-      .free_data = clutter_renderer_free_data
+      .free_data = clutter_renderer_free_data,
+      .slides_dropped = clutter_renderer_slides_dropped,
+      .release_assets = clutter_renderer_release_assets
     }
 };
 
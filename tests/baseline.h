@@ -0,0 +1,286 @@
+/*
+ * Pinpoint: A small-ish presentation tool
+ *
+ * Copyright (C) 2010 Intel Corporation
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option0 any later version.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * The parser as it was before the settings table, kept as a reference to
+ * compare the current one with. Include after pp-test.h. It knows nothing
+ * of the settings added since, like video-start.
+ */
+
+static void
+baseline_parse_setting (PinPointPoint *point,
+                        const char    *setting)
+{
+/* C Preprocessor macros implemeting a mini language for interpreting
+ * pinpoint key=value pairs
+ */
+
+#define START_PARSER if (0) {
+#define DEFAULT      } else {
+#define END_PARSER   }
+#define IF_PREFIX(prefix) } else if (g_str_has_prefix (setting, prefix)) {
+#define IF_EQUAL(string) } else if (g_str_equal (setting, string)) {
+#define STRING  g_intern_string (strchr (setting, '=') + 1)
+#define INT     atoi (strchr (setting, '=') + 1)
+#define FLOAT   g_ascii_strtod (strchr (setting, '=') + 1, NULL)
+#define RESOLUTION(r) parse_resolution (&r, strchr (setting, '=') + 1)
+#define ENUM(r,t,s) \
+  do { \
+      int _i; \
+      EnumDescription *_d = t##_desc; \
+      r = _d[0].value; \
+      for (_i = 0; _d[_i].name; _i++) \
+        if (g_strcmp0 (_d[_i].name, s) == 0) \
+          r = _d[_i].value; \
+  } while (0)
+
+  START_PARSER
+  IF_PREFIX("stage-color=") point->stage_color = STRING;
+  IF_PREFIX("font=")        point->font = STRING;
+  IF_PREFIX("notes-font=")  point->notes_font = STRING;
+  IF_PREFIX("notes-font-size=")  point->notes_font_size = STRING;
+  IF_PREFIX("text-color=")  point->text_color = STRING;
+  IF_PREFIX("text-align=")  ENUM(point->text_align, PPTextAlign, STRING);
+  IF_PREFIX("shading-color=") point->shading_color = STRING;
+  IF_PREFIX("shading-opacity=") point->shading_opacity = FLOAT;
+  IF_PREFIX("duration=")   point->duration = FLOAT;
+  IF_PREFIX("command=")    point->command = STRING;
+  IF_PREFIX("transition=") point->transition = STRING;
+  IF_PREFIX("camera-framerate=")  point->camera_framerate = INT;
+  IF_PREFIX("camera-resolution=") RESOLUTION (point->camera_resolution);
+  IF_EQUAL("fill")         point->bg_scale = PP_BG_FILL;
+  IF_EQUAL("fit")          point->bg_scale = PP_BG_FIT;
+  IF_EQUAL("stretch")      point->bg_scale = PP_BG_STRETCH;
+  IF_EQUAL("unscaled")     point->bg_scale = PP_BG_UNSCALED;
+  IF_EQUAL("center")       point->position = CLUTTER_GRAVITY_CENTER;
+  IF_EQUAL("top")          point->position = CLUTTER_GRAVITY_NORTH;
+  IF_EQUAL("bottom")       point->position = CLUTTER_GRAVITY_SOUTH;
+  IF_EQUAL("left")         point->position = CLUTTER_GRAVITY_WEST;
+  IF_EQUAL("right")        point->position = CLUTTER_GRAVITY_EAST;
+  IF_EQUAL("top-left")     point->position = CLUTTER_GRAVITY_NORTH_WEST;
+  IF_EQUAL("top-right")    point->position = CLUTTER_GRAVITY_NORTH_EAST;
+  IF_EQUAL("bottom-left")  point->position = CLUTTER_GRAVITY_SOUTH_WEST;
+  IF_EQUAL("bottom-right") point->position = CLUTTER_GRAVITY_SOUTH_EAST;
+  IF_EQUAL("no-markup")    point->use_markup = FALSE;
+  IF_EQUAL("markup")       point->use_markup = TRUE;
+  DEFAULT                  point->bg = g_intern_string (setting);
+  END_PARSER
+
+/* undefine the overrides, returning us to regular C */
+#undef START_PARSER
+#undef END_PARSER
+#undef DEFAULT
+#undef IF_PREFIX
+#undef IF_EQUAL
+#undef FLOAT
+#undef STRING
+#undef INT
+#undef ENUM
+#undef RESOLUTION
+}
+
+static void
+baseline_parse_config (PinPointPoint *point,
+                       const char    *config)
+{
+  GString    *str = g_string_new ("");
+  const char *p;
+
+  for (p = config; *p; p++)
+    {
+      if (*p != '[')
+        continue;
+
+      p++;
+      g_string_truncate (str, 0);
+      while (*p && *p != ']' && *p != '\n')
+        {
+          g_string_append_c (str, *p);
+          p++;
+        }
+
+      if (*p == ']')
+        baseline_parse_setting (point, str->str);
+      if (!*p) /* the original read past the end here */
+        break;
+    }
+  g_string_free (str, TRUE);
+}
+
+/* The slide loop of pp_parse_slides () from the same time, adding the points
+ * to points instead of making them, with the header applied to defaults.
+ * Where it read past the end of a buffer it is guarded, doing what the
+ * current parser does there; those spots are marked.
+ */
+static void
+baseline_parse_slides (const char    *slide_src,
+                       PinPointPoint *defaults,
+                       GPtrArray     *points)
+{
+  const char    *p;
+  gboolean       done        = FALSE;
+  gboolean       startofline = TRUE;
+  gboolean       gotconfig   = FALSE;
+  GString       *slide_str   = g_string_new ("");
+  GString       *setting_str = g_string_new ("");
+  GString       *notes_str   = g_string_new ("");
+  PinPointPoint *point, *next_point;
+
+  point = g_new0 (PinPointPoint, 1);
+  *point = *defaults;
+
+  for (p = slide_src; *p; p++)
+    {
+      switch (*p)
+        {
+          case '\\': /* escape the next char */
+            p++;
+            startofline = FALSE;
+            if (*p)
+              g_string_append_c (slide_str, *p);
+            else /* guarded: stepped past the end */
+              p--;
+            break;
+          case '\n':
+            startofline = TRUE;
+            g_string_append_c (slide_str, *p);
+            break;
+          case '-': /* slide seperator */
+            close_last_slide:
+            if (startofline)
+              {
+                next_point = g_new0 (PinPointPoint, 1);
+                *next_point = *defaults;
+
+                g_string_assign (setting_str, "");
+                while (*p && *p!='\n')  /* until newline */
+                  {
+                    g_string_append_c (setting_str, *p);
+                    p++;
+                  }
+                baseline_parse_config (next_point, setting_str->str);
+
+                if (!gotconfig)
+                  {
+                    baseline_parse_config (defaults, slide_str->str);
+                    *point = *defaults;
+                    baseline_parse_config (point, setting_str->str);
+                    g_free (next_point);
+                    gotconfig = TRUE;
+                    g_string_assign (slide_str, "");
+                    g_string_assign (setting_str, "");
+                    g_string_assign (notes_str, "");
+                  }
+                else
+                  {
+                    if (point->bg && point->bg[0])
+                      {
+                        char *filename = g_strdup (point->bg);
+                        int i = 0;
+
+                        while (filename[i])
+                          {
+                            filename[i] = tolower(filename[i]);
+                            i++;
+                          }
+
+                        if (strcmp (filename, "camera") == 0)
+                          point->bg_type = PP_BG_CAMERA;
+                        else if (str_has_video_suffix (filename))
+                          point->bg_type = PP_BG_VIDEO;
+                        else if (g_str_has_suffix (filename, ".svg"))
+                          point->bg_type = PP_BG_SVG;
+                        else if (pp_is_color (point->bg))
+                          point->bg_type = PP_BG_COLOR;
+                        else
+                          point->bg_type = PP_BG_IMAGE;
+                        g_free (filename);
+                      }
+
+                    {
+                      char *str = slide_str->str;
+
+                      while (*str == '\n') str++;
+                      /* guarded: read before the buffer when empty */
+                      while (slide_str->str[0] &&
+                             slide_str->str[strlen(slide_str->str)-1]=='\n')
+                        slide_str->str[strlen(slide_str->str)-1]='\0';
+
+                      point->text = g_intern_string (str);
+                    }
+                    if (notes_str->str[0])
+                      point->speaker_notes = g_strdup (notes_str->str);
+
+                    g_string_assign (slide_str, "");
+                    g_string_assign (setting_str, "");
+                    g_string_assign (notes_str, "");
+
+                    g_ptr_array_add (points, point);
+                    point = next_point;
+                  }
+
+                if (!*p) /* guarded: stepped past the end */
+                  p--;
+              }
+            else
+              {
+                g_string_append_c (slide_str, *p);
+              }
+            break;
+        case '#': /* comment */
+          if (startofline)
+            {
+              const char *end = p + 1;
+              while (*end != '\n' && *end != '\0')
+                {
+                  g_string_append_c (notes_str, *end);
+                  end++;
+                }
+              if (end)
+                {
+                  g_string_append_c (notes_str, '\n');
+                  p = *end ? end : end - 1; /* guarded: stepped past the end */
+                  break;
+                }
+            }
+          /* flow through */
+          default:
+            startofline = FALSE;
+            g_string_append_c (slide_str, *p);
+            break;
+        }
+
+      if (done) /* guarded: went on past the end */
+        break;
+    }
+
+  if (!done)
+    {
+      done = TRUE;
+      /* guarded: without a newline at the end the last slide was lost and
+       * the loop went on past the end */
+      startofline = TRUE;
+      goto close_last_slide;
+    }
+
+  g_free (point);
+  g_string_free (slide_str, TRUE);
+  g_string_free (setting_str, TRUE);
+  g_string_free (notes_str, TRUE);
+}
@@ -0,0 +1,249 @@
+/*
+ * Pinpoint: A small-ish presentation tool
+ *
+ * Copyright (C) 2010 Intel Corporation
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option0 any later version.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * The tests build pinpoint.c into themselves, so they can look at its
+ * statics, and present slides with a renderer that only counts what it is
+ * asked to do. Nothing runs a main loop, so slides are only made when a
+ * test asks for them with pp_slide_ready ().
+ */
+
+#include <string.h>
+#include <glib.h>
+
+/* GStringChunk does not tell how much it holds, so what goes into each is
+ * counted here; pinpoint.c is built with these in place of GLib's.
+ */
+static GHashTable *test_chunks = NULL; /* GStringChunk -> TestChunk */
+
+typedef struct
+{
+  gsize       bytes;
+  GHashTable *consts; /* strings given to insert_const () */
+} TestChunk;
+
+static void
+test_chunk_free (gpointer data)
+{
+  TestChunk *use = data;
+
+  g_hash_table_destroy (use->consts);
+  g_free (use);
+}
+
+static GStringChunk *
+test_string_chunk_new (gsize size)
+{
+  GStringChunk *chunk = g_string_chunk_new (size);
+  TestChunk    *use   = g_new0 (TestChunk, 1);
+
+  if (!test_chunks)
+    test_chunks = g_hash_table_new_full (NULL, NULL, NULL, test_chunk_free);
+  use->consts = g_hash_table_new (g_str_hash, g_str_equal);
+  g_hash_table_insert (test_chunks, chunk, use);
+
+  return chunk;
+}
+
+static void
+test_string_chunk_free (GStringChunk *chunk)
+{
+  g_hash_table_remove (test_chunks, chunk);
+  g_string_chunk_free (chunk);
+}
+
+static gchar *
+test_string_chunk_insert_len (GStringChunk *chunk,
+                              const gchar  *string,
+                              gssize        len)
+{
+  TestChunk *use = g_hash_table_lookup (test_chunks, chunk);
+
+  use->bytes += (len < 0 ? strlen (string) : (gsize) len) + 1;
+  return g_string_chunk_insert_len (chunk, string, len);
+}
+
+static gchar *
+test_string_chunk_insert (GStringChunk *chunk,
+                          const gchar  *string)
+{
+  return test_string_chunk_insert_len (chunk, string, -1);
+}
+
+static gchar *
+test_string_chunk_insert_const (GStringChunk *chunk,
+                                const gchar  *string)
+{
+  TestChunk *use = g_hash_table_lookup (test_chunks, chunk);
+  gchar     *ret = g_string_chunk_insert_const (chunk, string);
+
+  if (!g_hash_table_lookup (use->consts, ret))
+    {
+      use->bytes += strlen (string) + 1;
+      g_hash_table_insert (use->consts, ret, ret);
+    }
+  return ret;
+}
+
+#define g_string_chunk_new          test_string_chunk_new
+#define g_string_chunk_free         test_string_chunk_free
+#define g_string_chunk_insert       test_string_chunk_insert
+#define g_string_chunk_insert_len   test_string_chunk_insert_len
+#define g_string_chunk_insert_const test_string_chunk_insert_const
+
+#define main pinpoint_main
+#include "pinpoint.c"
+#undef main
+
+/* bytes held by the chunk of the current parse */
+static gsize
+test_strings_size (void)
+{
+  TestChunk *use;
+
+  if (!pp_strings)
+    return 0;
+  use = g_hash_table_lookup (test_chunks, pp_strings);
+  return use->bytes;
+}
+
+typedef struct
+{
+  PinPointRenderer renderer;
+  guint            made;    /* make_point () calls */
+  guint            freed;   /* free_data () calls */
+} TestRenderer;
+
+static gboolean
+test_make_point (PinPointRenderer *renderer,
+                 PinPointPoint    *point)
+{
+  ((TestRenderer *) renderer)->made++;
+  return TRUE;
+}
+
+static void *
+test_allocate_data (PinPointRenderer *renderer)
+{
+  return g_new0 (gint, 1);
+}
+
+static void
+test_free_data (PinPointRenderer *renderer,
+                void             *datap)
+{
+  ((TestRenderer *) renderer)->freed++;
+  g_free (datap);
+}
+
+static TestRenderer test_renderer =
+{
+  {
+    .make_point    = test_make_point,
+    .allocate_data = test_allocate_data,
+    .free_data     = test_free_data,
+  },
+};
+
+PinPointRenderer *
+pp_clutter_renderer (void)
+{
+  return &test_renderer.renderer;
+}
+
+#ifdef HAVE_PDF
+PinPointRenderer *
+pp_cairo_renderer (void)
+{
+  return &test_renderer.renderer;
+}
+#endif
+
+/* forgets the presentation, as if pinpoint had just started */
+static void
+test_reset (void)
+{
+  PinPointRenderer *renderer = &test_renderer.renderer;
+  guint             i;
+
+  for (i = 0; i < pp_slide_count (); i++)
+    pin_point_free (renderer, pp_slide_nth (i));
+  if (pp_slides)
+    g_ptr_array_free (pp_slides, TRUE);
+  pp_slides = NULL;
+  pp_slideno = -1;
+
+  if (pp_strings)
+    g_string_chunk_free (pp_strings);
+  pp_strings = NULL;
+  g_free (renderer->source);
+  renderer->source = NULL;
+
+  if (pp_stream_pending)
+    g_string_free (pp_stream_pending, TRUE);
+  pp_stream_pending = NULL;
+  pp_stream_header = TRUE;
+  pp_stream_dropped = 0;
+
+  default_point = pin_default_point;
+  pp_assets_sweep (NULL);
+  pp_cache_probed = FALSE;
+  test_renderer.made = test_renderer.freed = 0;
+}
+
+/* makes all the slides, like presenting them one after the other would */
+static void
+test_make_all (void)
+{
+  guint i;
+
+  for (i = 0; i < pp_slide_count (); i++)
+    pp_slide_ready (i);
+}
+
+/* the settings and text of @a and @b are the same */
+static void
+test_assert_points_equal (PinPointPoint *a,
+                          PinPointPoint *b)
+{
+  g_assert_cmpstr (a->stage_color, ==, b->stage_color);
+  g_assert_cmpstr (a->bg, ==, b->bg);
+  g_assert_cmpint (a->bg_type, ==, b->bg_type);
+  g_assert_cmpint (a->bg_scale, ==, b->bg_scale);
+  g_assert_cmpstr (a->text, ==, b->text);
+  g_assert_cmpint (a->position, ==, b->position);
+  g_assert_cmpstr (a->font, ==, b->font);
+  g_assert_cmpstr (a->notes_font, ==, b->notes_font);
+  g_assert_cmpstr (a->notes_font_size, ==, b->notes_font_size);
+  g_assert_cmpint (a->text_align, ==, b->text_align);
+  g_assert_cmpstr (a->text_color, ==, b->text_color);
+  g_assert_cmpint (a->use_markup, ==, b->use_markup);
+  g_assert_cmpfloat (a->duration, ==, b->duration);
+  g_assert_cmpstr (a->speaker_notes, ==, b->speaker_notes);
+  g_assert_cmpstr (a->shading_color, ==, b->shading_color);
+  g_assert_cmpfloat (a->shading_opacity, ==, b->shading_opacity);
+  g_assert_cmpstr (a->transition, ==, b->transition);
+  g_assert_cmpstr (a->command, ==, b->command);
+  g_assert_cmpfloat (a->video_start, ==, b->video_start);
+  g_assert_cmpint (a->camera_framerate, ==, b->camera_framerate);
+  g_assert_cmpint (a->camera_resolution.width, ==,
+                   b->camera_resolution.width);
+  g_assert_cmpint (a->camera_resolution.height, ==,
+                   b->camera_resolution.height);
+}
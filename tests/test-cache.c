@@ -0,0 +1,233 @@
+/*
+ * Pinpoint: A small-ish presentation tool
+ *
+ * Copyright (C) 2010 Intel Corporation
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option0 any later version.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "pp-test.h"
+
+#include <utime.h>
+#include <glib/gstdio.h>
+
+#define N_IMAGES 16
+
+/* a directory with copies of bg.jpg in it, that the presentation and its
+ * cache live in */
+static char *
+test_dir_new (void)
+{
+  char  *dir = g_dir_make_tmp ("pinpoint-XXXXXX", NULL);
+  char  *contents;
+  gsize  length;
+  guint  i;
+
+  g_assert (dir);
+  g_assert (g_file_get_contents (PINPOINT_SRCDIR "bg.jpg", &contents,
+                                 &length, NULL));
+  for (i = 0; i < N_IMAGES; i++)
+    {
+      char *name = g_strdup_printf ("bg%u.jpg", i);
+      char *path = g_build_filename (dir, name, NULL);
+
+      g_assert (g_file_set_contents (path, contents, length, NULL));
+      g_free (path);
+      g_free (name);
+    }
+  g_free (contents);
+
+  pp_cache_file = g_build_filename (dir, "test.cache", NULL);
+  pp_basedir = g_file_new_for_path (dir);
+
+  return dir;
+}
+
+static void
+test_dir_free (char *dir)
+{
+  GDir       *d = g_dir_open (dir, 0, NULL);
+  const char *name;
+
+  test_reset ();
+
+  while ((name = g_dir_read_name (d)))
+    {
+      char *path = g_build_filename (dir, name, NULL);
+
+      g_remove (path);
+      g_free (path);
+    }
+  g_dir_close (d);
+  g_rmdir (dir);
+  g_free (dir);
+
+  g_free (pp_cache_file);
+  pp_cache_file = NULL;
+  g_free (pp_cache_stored);
+  pp_cache_stored = NULL;
+  g_object_unref (pp_basedir);
+  pp_basedir = NULL;
+}
+
+/* a presentation of @n slides, going through the images */
+static char *
+test_deck_new (guint n)
+{
+  GString *str = g_string_new ("[black]\n");
+  guint    i;
+
+  for (i = 0; i < n; i++)
+    g_string_append_printf (str, "-- [bg%u.jpg] [fill]\nslide %u\n"
+                            "# notes %u\n", i % N_IMAGES, i, i);
+
+  return g_string_free (str, FALSE);
+}
+
+/* what is parsed from the cache is what the parser made */
+static void
+test_cache_same (void)
+{
+  PinPointRenderer *renderer = &test_renderer.renderer;
+  char             *dir, *deck, *parsed, *cached;
+
+  test_reset ();
+  dir = test_dir_new ();
+  deck = test_deck_new (50);
+
+  pp_parse_slides (renderer, deck);
+  g_assert (g_file_test (pp_cache_file, G_FILE_TEST_EXISTS));
+  parsed = pp_serialize ();
+
+  test_reset ();
+  pp_parse_slides (renderer, deck);
+  cached = pp_serialize ();
+
+  g_assert_cmpuint (pp_slide_count (), ==, 50);
+  g_assert_cmpstr (parsed, ==, cached);
+  g_assert_cmpstr (pp_slide_nth (17)->asset->path, ==,
+                   pp_slide_nth (1)->asset->path);
+  g_assert (pp_slide_nth (17)->asset == pp_slide_nth (1)->asset);
+
+  g_free (cached);
+  g_free (parsed);
+  g_free (deck);
+  test_dir_free (dir);
+}
+
+/* image sizes come from the cache while the files keep their mtime */
+static void
+test_cache_assets (void)
+{
+  PinPointRenderer *renderer = &test_renderer.renderer;
+  PinPointAsset    *asset;
+  struct utimbuf    times = { 1000000000, 1000000000 };
+  char             *dir, *deck;
+  gint              width, height, w, h;
+
+  test_reset ();
+  dir = test_dir_new ();
+  deck = test_deck_new (4);
+
+  pp_parse_slides (renderer, deck);
+  asset = pp_slide_nth (0)->asset;
+  g_assert (pp_asset_get_size (asset, &width, &height));
+  g_assert (pp_cache_probed);
+  pp_cache_save (renderer->source);
+  g_assert (!pp_cache_probed);
+
+  /* starting again does not look at the image */
+  test_reset ();
+  pp_parse_slides (renderer, deck);
+  asset = pp_slide_nth (0)->asset;
+  g_assert (!asset->probed);
+  g_assert (pp_asset_get_size (asset, &w, &h));
+  g_assert (!pp_cache_probed);
+  g_assert_cmpint (w, ==, width);
+  g_assert_cmpint (h, ==, height);
+
+  /* unless it changed */
+  g_assert_cmpint (g_utime (asset->path, &times), ==, 0);
+  test_reset ();
+  pp_parse_slides (renderer, deck);
+  asset = pp_slide_nth (0)->asset;
+  g_assert (pp_asset_get_size (asset, &w, &h));
+  g_assert (pp_cache_probed);
+  g_assert_cmpint (asset->mtime, ==, 1000000000);
+  g_assert_cmpint (w, ==, width);
+
+  g_free (deck);
+  test_dir_free (dir);
+}
+
+static double
+test_first_slide (const char *deck)
+{
+  PinPointRenderer *renderer = &test_renderer.renderer;
+  GTimer           *timer = g_timer_new ();
+  PinPointPoint    *point;
+  gint              width, height;
+  double            ret;
+
+  pp_parse_slides (renderer, deck);
+  point = pp_slide_ready (0);
+  pp_asset_get_size (point->asset, &width, &height);
+  ret = g_timer_elapsed (timer, NULL);
+  g_timer_destroy (timer);
+
+  return ret;
+}
+
+/* time to the first slide, without and with the cache */
+static void
+test_cache_timing (void)
+{
+  PinPointRenderer *renderer = &test_renderer.renderer;
+  guint             n = g_test_perf () ? 5000 : 500;
+  double            cold, warm;
+  char             *dir, *deck;
+
+  test_reset ();
+  dir = test_dir_new ();
+  deck = test_deck_new (n);
+
+  cold = test_first_slide (deck);
+  /* what presenting and quitting leaves in the cache */
+  pp_cache_save (renderer->source);
+
+  test_reset ();
+  warm = test_first_slide (deck);
+  g_assert (!pp_cache_probed);
+
+  g_test_message ("first of %u slides: %.2f ms parsed, %.2f ms cached",
+                  n, cold * 1000, warm * 1000);
+  g_test_minimized_result (warm, "first of %u slides cached in %.2f ms",
+                           n, warm * 1000);
+
+  g_free (deck);
+  test_dir_free (dir);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/cache/same", test_cache_same);
+  g_test_add_func ("/cache/assets", test_cache_assets);
+  g_test_add_func ("/cache/timing", test_cache_timing);
+
+  return g_test_run ();
+}
@@ -0,0 +1,167 @@
+/*
+ * Pinpoint: A small-ish presentation tool
+ *
+ * Copyright (C) 2010 Intel Corporation
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option0 any later version.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "pp-test.h"
+#include "baseline.h"
+
+/* the corners of the slide syntax */
+static const char *edges[] =
+{
+  "",
+  "\n",
+  "only a header, no slides\n",
+  "[black]\n--\n",
+  "--\nfirst\n--",
+  "--\nfirst\n-",
+  "--\nno newline at the end",
+  "--\ntext ending in an escape \\",
+  "--\n# a note on the last line",
+  "--\n#\n#\n",
+  "--\n\n\n\n--\n\n--\n",
+  "[font=Serif 20px] [top]\n# header note\n-- [white]\n\n\ntext\n\n\n",
+  "--\n\\-- not a separator\n\\# not a note\n\\\\ a backslash\n",
+  "--\nan escaped\\\nnewline\n\\\n-- [red]\n",
+  "--\na - b # c\n#note\n  #not a note\n-x is a separator\n",
+  "-- [bg.svg]\n-- [camera]\n-- [Movie.OGV]\n-- [#ff0000]\n-- [red]\n"
+  "-- [picture.png]\n-- [CAMERA]\n-- []\n",
+  "[bowls.jpg] [fill]\n-- [unscaled]\na\n-- [linus.jpg] [stretch]\nb\n",
+  "header\n--\nfirst\n-- [transition=sheet] [duration=2.5]\nsecond\n"
+  "# notes\n# more notes\nthird line\n",
+};
+
+/* pieces of lines to build random presentations from */
+static const char *fragments[] =
+{
+  "--",
+  "-- [black]",
+  "-- [bowls.jpg] [fill] [bottom-left]",
+  "-- [camera] [camera-framerate=15]",
+  "-- [clip.webm] [transition=fade]",
+  "-- [#123456] [top-left] [no-markup]",
+  "--[font=Monospace 18px][shading-opacity=1.0]",
+  "-",
+  "# a note",
+  "#",
+  "text",
+  "more text - with a dash",
+  "  indented # not a note",
+  "\\-- not a separator",
+  "\\# not a note",
+  "\\\\",
+  "an escape at the end \\",
+  "",
+  "[font=Serif 20px]",
+  "[transition=sheet] [duration=2]",
+  "<b>markup</b> [not a setting]",
+};
+
+/* parses src with both parsers and checks they agree */
+static void
+assert_parse_same (const char *src)
+{
+  GPtrArray     *points   = g_ptr_array_new ();
+  GPtrArray     *baseline = g_ptr_array_new ();
+  PinPointPoint  defaults = pin_default_point;
+  guint          i;
+
+  test_reset ();
+  pp_strings = g_string_chunk_new (4096);
+
+  pp_parse_points (src, TRUE, points);
+  baseline_parse_slides (src, &defaults, baseline);
+
+  test_assert_points_equal (&default_point, &defaults);
+  g_assert_cmpuint (points->len, ==, baseline->len);
+  for (i = 0; i < points->len; i++)
+    test_assert_points_equal (g_ptr_array_index (points, i),
+                              g_ptr_array_index (baseline, i));
+
+  for (i = 0; i < points->len; i++)
+    pin_point_free (&test_renderer.renderer, g_ptr_array_index (points, i));
+  for (i = 0; i < baseline->len; i++)
+    {
+      PinPointPoint *point = g_ptr_array_index (baseline, i);
+
+      g_free (point->speaker_notes);
+      g_free (point);
+    }
+  g_ptr_array_free (points, TRUE);
+  g_ptr_array_free (baseline, TRUE);
+}
+
+static void
+test_parse_introduction (void)
+{
+  GError *error = NULL;
+  char   *src;
+
+  g_file_get_contents (PINPOINT_SRCDIR "introduction.pin", &src, NULL,
+                       &error);
+  g_assert_no_error (error);
+  assert_parse_same (src);
+  g_free (src);
+}
+
+static void
+test_parse_edges (void)
+{
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (edges); i++)
+    assert_parse_same (edges[i]);
+}
+
+/* Presentations of random lines, the same ones on every run. */
+static void
+test_parse_random (void)
+{
+  GRand   *rand = g_rand_new_with_seed (4242);
+  GString *src  = g_string_new ("");
+  guint    i, j, lines;
+
+  for (i = 0; i < 2000; i++)
+    {
+      g_string_truncate (src, 0);
+      lines = g_rand_int_range (rand, 0, 40);
+      for (j = 0; j < lines; j++)
+        {
+          g_string_append (src, fragments[g_rand_int_range (rand, 0,
+                                          G_N_ELEMENTS (fragments))]);
+          if (j + 1 < lines || g_rand_boolean (rand))
+            g_string_append_c (src, '\n');
+        }
+      assert_parse_same (src->str);
+    }
+
+  g_string_free (src, TRUE);
+  g_rand_free (rand);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/parse/introduction", test_parse_introduction);
+  g_test_add_func ("/parse/edges", test_parse_edges);
+  g_test_add_func ("/parse/random", test_parse_random);
+
+  return g_test_run ();
+}
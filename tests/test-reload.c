@@ -0,0 +1,468 @@
+/*
+ * Pinpoint: A small-ish presentation tool
+ *
+ * Copyright (C) 2010 Intel Corporation
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option0 any later version.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "pp-test.h"
+
+#include <stdio.h>
+#include <unistd.h>
+
+static const char *deck =
+  "[font=Sans 50px][black]\n"
+  "-- [white]\n"
+  "first slide\n"
+  "-- [red] [top-left]\n"
+  "second slide\n"
+  "# a note\n"
+  "-- [blue]\n"
+  "third slide\n"
+  "-- [green] [no-markup]\n"
+  "fourth slide\n"
+  "-- [gray]\n"
+  "fifth slide\n";
+
+/* the same, with the third slide edited */
+static const char *deck_edited =
+  "[font=Sans 50px][black]\n"
+  "-- [white]\n"
+  "first slide\n"
+  "-- [red] [top-left]\n"
+  "second slide\n"
+  "# a note\n"
+  "-- [blue]\n"
+  "third slide, edited\n"
+  "-- [green] [no-markup]\n"
+  "fourth slide\n"
+  "-- [gray]\n"
+  "fifth slide\n";
+
+typedef struct
+{
+  PinPointPoint *point;
+  void          *data;
+} Made;
+
+static Made *
+remember_slides (void)
+{
+  Made  *made = g_new0 (Made, pp_slide_count ());
+  guint  i;
+
+  for (i = 0; i < pp_slide_count (); i++)
+    {
+      made[i].point = pp_slide_nth (i);
+      made[i].data = made[i].point->data;
+    }
+  return made;
+}
+
+/* editing one slide keeps the points, and the renderer data, of the
+ * others */
+static void
+test_reload_keeps_unchanged (void)
+{
+  PinPointRenderer *renderer = &test_renderer.renderer;
+  Made             *made;
+  guint             i;
+
+  test_reset ();
+  pp_parse_slides (renderer, deck);
+  test_make_all ();
+  g_assert_cmpuint (pp_slide_count (), ==, 5);
+  g_assert_cmpuint (test_renderer.made, ==, 5);
+  made = remember_slides ();
+
+  pp_parse_slides (renderer, deck_edited);
+  g_assert_cmpuint (pp_slide_count (), ==, 5);
+
+  for (i = 0; i < pp_slide_count (); i++)
+    {
+      PinPointPoint *point = pp_slide_nth (i);
+
+      if (i == 2)
+        {
+          g_assert (point != made[i].point);
+          g_assert (!point->ready);
+          g_assert (point->data == NULL);
+          g_assert_cmpstr (point->text, ==, "third slide, edited");
+          continue;
+        }
+
+      g_assert (point == made[i].point);
+      g_assert (point->ready);
+      g_assert (point->data == made[i].data);
+    }
+
+  /* only the edited slide went, and nothing was made again */
+  g_assert_cmpuint (test_renderer.freed, ==, 1);
+  g_assert_cmpuint (test_renderer.made, ==, 5);
+  g_assert_cmpint (pp_slideno, ==, 2);
+
+  /* the kept points took the settings of the new parse */
+  g_assert_cmpstr (pp_slide_nth (1)->speaker_notes, ==, " a note\n");
+  g_assert_cmpint (pp_slide_nth (1)->position, ==, CLUTTER_GRAVITY_NORTH_WEST);
+  g_assert_cmpstr (pp_slide_nth (3)->text, ==, "fourth slide");
+
+  g_free (made);
+}
+
+/* slides that moved are found by their text, not their position */
+static void
+test_reload_insert (void)
+{
+  PinPointRenderer *renderer = &test_renderer.renderer;
+  Made             *made;
+  GString          *src;
+  guint             i;
+
+  test_reset ();
+  pp_parse_slides (renderer, deck);
+  test_make_all ();
+  made = remember_slides ();
+
+  src = g_string_new (deck);
+  g_string_insert (src, strstr (deck, "-- [red]") - deck,
+                   "-- [yellow]\nan inserted slide\n");
+  pp_parse_slides (renderer, src->str);
+  g_assert_cmpuint (pp_slide_count (), ==, 6);
+
+  g_assert (pp_slide_nth (0) == made[0].point);
+  g_assert (!pp_slide_nth (1)->ready);
+  for (i = 1; i < 5; i++)
+    {
+      g_assert (pp_slide_nth (i + 1) == made[i].point);
+      g_assert (pp_slide_nth (i + 1)->data == made[i].data);
+    }
+  g_assert_cmpuint (test_renderer.freed, ==, 0);
+  g_assert_cmpint (pp_slideno, ==, 1);
+
+  g_string_free (src, TRUE);
+  g_free (made);
+}
+
+/* a changed header changes the defaults of every slide */
+static void
+test_reload_header (void)
+{
+  PinPointRenderer *renderer = &test_renderer.renderer;
+  Made             *made;
+  char             *src;
+  guint             i;
+
+  test_reset ();
+  pp_parse_slides (renderer, deck);
+  test_make_all ();
+  made = remember_slides ();
+
+  src = g_strconcat ("[font=Sans 40px]", deck + strlen ("[font=Sans 50px]"),
+                     NULL);
+  pp_parse_slides (renderer, src);
+  g_assert_cmpuint (pp_slide_count (), ==, 5);
+  for (i = 0; i < pp_slide_count (); i++)
+    {
+      g_assert (pp_slide_nth (i) != made[i].point);
+      g_assert_cmpstr (pp_slide_nth (i)->font, ==, "Sans 40px");
+    }
+  g_assert_cmpuint (test_renderer.freed, ==, 5);
+
+  g_free (src);
+  g_free (made);
+}
+
+/* every reload starts the strings over, they do not pile up */
+static void
+test_reload_strings (void)
+{
+  PinPointRenderer *renderer = &test_renderer.renderer;
+  gsize             size, edited_size;
+  guint             i;
+
+  test_reset ();
+  pp_parse_slides (renderer, deck);
+  test_make_all ();
+  size = test_strings_size ();
+
+  /* the strings are pieces of the source, each with its NUL */
+  g_assert_cmpuint (size, >, 0);
+  g_assert_cmpuint (size, <=, 2 * strlen (deck));
+
+  pp_parse_slides (renderer, deck_edited);
+  edited_size = test_strings_size ();
+
+  for (i = 0; i < 100; i++)
+    {
+      pp_parse_slides (renderer, deck);
+      g_assert_cmpuint (test_strings_size (), ==, size);
+      pp_parse_slides (renderer, deck_edited);
+      g_assert_cmpuint (test_strings_size (), ==, edited_size);
+    }
+
+  g_test_message ("%" G_GSIZE_FORMAT " bytes of strings for a %" G_GSIZE_FORMAT
+                  " byte presentation, after 200 reloads", size, strlen (deck));
+}
+
+/* backgrounds no slide uses any more are let go of */
+static void
+test_reload_assets (void)
+{
+  PinPointRenderer *renderer = &test_renderer.renderer;
+  guint             i;
+  char             *src;
+
+  test_reset ();
+  for (i = 0; i < 200; i++)
+    {
+      /* a regenerated presentation, with new file names each time */
+      src = g_strdup_printf ("[black]\n-- [a%u.jpg]\none\n-- [b%u.png]\n"
+                             "two\n-- [shared.jpg]\nthree\n", i, i);
+      pp_parse_slides (renderer, src);
+      g_free (src);
+
+      g_assert_cmpuint (g_hash_table_size (pp_assets_by_name), <=, 3);
+    }
+}
+
+/* a presentation of @n slides, with the slide @version % @n edited to
+ * show @version on a background of its own */
+static char *
+test_deck_new (guint n,
+               guint version)
+{
+  GString *str = g_string_new ("[font=Sans 50px][black]\n");
+  guint    i;
+
+  for (i = 0; i < n; i++)
+    {
+      if (i == version % n)
+        g_string_append_printf (str, "-- [v%u.jpg] [fill]\nversion %u\n",
+                                version, version);
+      else
+        g_string_append_printf (str, "-- [white]\nslide %u\n# notes %u\n",
+                                i, i);
+    }
+
+  return g_string_free (str, FALSE);
+}
+
+/* the resident set size, from /proc/self/statm, or 0 where there is none */
+static gsize
+test_rss (void)
+{
+  char  *contents;
+  gsize  pages = 0;
+
+  if (!g_file_get_contents ("/proc/self/statm", &contents, NULL, NULL))
+    return 0;
+  sscanf (contents, "%*u %" G_GSIZE_FORMAT, &pages);
+  g_free (contents);
+
+  return pages * sysconf (_SC_PAGESIZE);
+}
+
+/* reloading a big presentation over and over does not grow the process;
+ * 10000 reloads of 1000 slides with -m perf */
+static void
+test_reload_rss (void)
+{
+  PinPointRenderer *renderer = &test_renderer.renderer;
+  guint             reloads = g_test_perf () ? 10000 : 200;
+  guint             i;
+  gsize             rss, start = 0, max = 0;
+  char             *src;
+
+  if (!test_rss ())
+    {
+      g_test_message ("no /proc/self/statm, not measuring");
+      return;
+    }
+
+  test_reset ();
+  for (i = 0; i < reloads; i++)
+    {
+      src = test_deck_new (1000, i);
+      pp_parse_slides (renderer, src);
+      g_free (src);
+
+      /* the presenter is on the slide that changed */
+      pp_slide_ready (i % pp_slide_count ());
+
+      /* allocators settle during the first reloads */
+      rss = test_rss ();
+      if (i == reloads / 10)
+        start = rss;
+      max = MAX (max, rss);
+    }
+
+  g_test_message ("%" G_GSIZE_FORMAT " kB resident after %u reloads of 1000 "
+                  "slides, %" G_GSIZE_FORMAT " kB after %u, at most %"
+                  G_GSIZE_FORMAT " kB", rss / 1024, reloads, start / 1024,
+                  reloads / 10, max / 1024);
+  g_assert_cmpuint (rss, <=, start + 4 * 1024 * 1024);
+}
+
+/* how long reloading after a one slide edit takes as presentations grow,
+ * run with -m perf */
+static void
+test_reload_latency (void)
+{
+  PinPointRenderer *renderer = &test_renderer.renderer;
+  GTimer           *timer = g_timer_new ();
+  guint             n, i;
+  double            elapsed = 0.0;
+  char             *src;
+
+  for (n = 25; n <= 6400; n *= 4)
+    {
+      test_reset ();
+      src = test_deck_new (n, 0);
+      pp_parse_slides (renderer, src);
+      g_free (src);
+      test_make_all ();
+
+      elapsed = 0.0;
+      for (i = 1; i <= 20; i++)
+        {
+          src = test_deck_new (n, i);
+          g_timer_start (timer);
+          pp_parse_slides (renderer, src);
+          pp_slide_ready (i % n);
+          elapsed += g_timer_elapsed (timer, NULL);
+          g_free (src);
+        }
+
+      g_test_message ("%u slides: %.3f ms per reload", n,
+                      elapsed * 1000 / 20);
+    }
+
+  g_test_minimized_result (elapsed / 20, "reloading %u slides: %.3f ms",
+                           n / 4, elapsed * 1000 / 20);
+  g_timer_destroy (timer);
+}
+
+/* with --stream-keep the strings of dropped slides are let go of */
+static void
+test_stream_strings (void)
+{
+  PinPointRenderer *renderer = &test_renderer.renderer;
+  gsize             slide_len, size, max_size = 0;
+  guint             i;
+  char             *slide;
+
+  test_reset ();
+  pp_stream_keep = 8;
+  pp_parse_slides (renderer, "");
+
+  pp_stream_append (renderer, "[black]\n", strlen ("[black]\n"), FALSE);
+  slide_len = strlen ("-- [white]\nslide 00000\n# note 00000\n");
+
+  for (i = 0; i < 2000; i++)
+    {
+      slide = g_strdup_printf ("-- [white]\nslide %05u\n# note %05u\n",
+                               i, i);
+      pp_stream_append (renderer, slide, strlen (slide), FALSE);
+      g_free (slide);
+
+      /* the presenter follows the stream */
+      pp_slideno = MAX ((gint) pp_slide_count () - 1, 0);
+      pp_slide_ready (pp_slideno);
+
+      g_assert_cmpuint (pp_slide_count (), <=, pp_stream_keep + 1);
+      size = test_strings_size ();
+      max_size = MAX (max_size, size);
+    }
+
+  /* each kept slide holds its source, text and notes; a slide's strings
+   * are only let go of once as many slides as are kept have been dropped */
+  g_assert_cmpuint (max_size, <=, 4 * 2 * (pp_stream_keep + 1) * slide_len);
+
+  g_test_message ("%" G_GSIZE_FORMAT " bytes of strings at most while "
+                  "streaming 2000 slides, keeping %d", max_size,
+                  pp_stream_keep);
+
+  pp_stream_append (renderer, "", 0, TRUE);
+  pp_stream_keep = 0;
+}
+
+/* with --stream-keep a slide still animating out is not dropped */
+static void
+test_stream_animating (void)
+{
+  PinPointRenderer *renderer = &test_renderer.renderer;
+  PinPointPoint    *left;
+  guint             i;
+  char             *slide;
+
+  test_reset ();
+  pp_stream_keep = 2;
+  pp_parse_slides (renderer, "");
+  pp_stream_append (renderer, "[black]\n", strlen ("[black]\n"), FALSE);
+
+  for (i = 0; i < 20; i++)
+    {
+      slide = g_strdup_printf ("-- [white]\nslide %u\n", i);
+      pp_stream_append (renderer, slide, strlen (slide), FALSE);
+      g_free (slide);
+    }
+  pp_slideno = pp_slide_count () - 1;
+
+  /* the presenter moves on, the slide left is animating out */
+  left = pp_slide_ready (pp_slideno);
+  pp_slide_set_animating (left, TRUE);
+  pp_slideno++;
+
+  for (i = 0; i < 20; i++)
+    {
+      slide = g_strdup_printf ("-- [white]\nmore %u\n", i);
+      pp_stream_append (renderer, slide, strlen (slide), FALSE);
+      g_free (slide);
+      pp_slideno = pp_slide_count () - 1;
+    }
+
+  g_assert_cmpint (pp_slide_index (left), ==, 0);
+  g_assert (left->ready);
+
+  /* once the transition is over it goes */
+  pp_slide_set_animating (left, FALSE);
+  pp_stream_append (renderer, "-- [white]\nlast\n",
+                    strlen ("-- [white]\nlast\n"), FALSE);
+  g_assert_cmpint (pp_slide_index (left), ==, -1);
+  g_assert_cmpuint (pp_slide_count (), <=, pp_stream_keep + 1);
+
+  pp_stream_append (renderer, "", 0, TRUE);
+  pp_stream_keep = 0;
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/reload/keeps-unchanged", test_reload_keeps_unchanged);
+  g_test_add_func ("/reload/insert", test_reload_insert);
+  g_test_add_func ("/reload/header", test_reload_header);
+  g_test_add_func ("/reload/strings", test_reload_strings);
+  g_test_add_func ("/reload/assets", test_reload_assets);
+  g_test_add_func ("/reload/rss", test_reload_rss);
+  if (g_test_perf ())
+    g_test_add_func ("/reload/latency", test_reload_latency);
+  g_test_add_func ("/stream/strings", test_stream_strings);
+  g_test_add_func ("/stream/animating", test_stream_animating);
+
+  return g_test_run ();
+}
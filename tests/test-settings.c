@@ -0,0 +1,113 @@
+/*
+ * Pinpoint: A small-ish presentation tool
+ *
+ * Copyright (C) 2010 Intel Corporation
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option0 any later version.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "pp-test.h"
+#include "baseline.h"
+
+/* separator lines like the ones in real presentations, and some that are
+ * not quite settings */
+static const char *configs[] =
+{
+  "--",
+  "-- [black]",
+  "-- [bowls.jpg] [fill] [bottom-left]",
+  "-- [linus.jpg] [text-align=center] [shading-opacity=0.0]",
+  "-- [font=Monospace 40px] [text-color=#00ff00] [top]",
+  "-- [stage-color=white] [text-color=black] [no-markup] [left]",
+  "-- [transition=sheet] [duration=2.5] [command=ls -l]",
+  "-- [camera] [camera-framerate=30] [camera-resolution=640x480]",
+  "-- [notes-font=Serif] [notes-font-size=14px] [shading-color=#112233]",
+  "-- [stretch] [unscaled] [fit] [center] [right] [top-right] [markup]",
+  "-- [text-align=bogus] [duration] [fill=yes] [=] [] [font=]",
+  "-- [unterminated",
+  "-- [bottom] [bottom-right] [shading-opacity=1] [text-align=right]",
+};
+
+static void
+test_settings_same (void)
+{
+  guint i;
+
+  test_reset ();
+  pp_strings = g_string_chunk_new (4096);
+
+  for (i = 0; i < G_N_ELEMENTS (configs); i++)
+    {
+      PinPointPoint point = pin_default_point, baseline = pin_default_point;
+
+      parse_config (&point, configs[i]);
+      baseline_parse_config (&baseline, configs[i]);
+      test_assert_points_equal (&point, &baseline);
+    }
+}
+
+/* Times both parsers on the lines above. Only reported, with -m perf for
+ * more rounds. */
+static void
+test_settings_timing (void)
+{
+  GTimer  *timer = g_timer_new ();
+  guint    rounds = g_test_perf () ? 200000 : 20000;
+  gdouble  table, chain;
+  guint    i, j;
+
+  test_reset ();
+  pp_strings = g_string_chunk_new (4096);
+
+  g_timer_start (timer);
+  for (i = 0; i < rounds; i++)
+    for (j = 0; j < G_N_ELEMENTS (configs); j++)
+      {
+        PinPointPoint point = pin_default_point;
+
+        parse_config (&point, configs[j]);
+      }
+  table = g_timer_elapsed (timer, NULL);
+
+  g_timer_start (timer);
+  for (i = 0; i < rounds; i++)
+    for (j = 0; j < G_N_ELEMENTS (configs); j++)
+      {
+        PinPointPoint point = pin_default_point;
+
+        baseline_parse_config (&point, configs[j]);
+      }
+  chain = g_timer_elapsed (timer, NULL);
+
+  g_test_minimized_result (table, "settings table: %.2fms for %u lines",
+                           table * 1000.0, rounds * G_N_ELEMENTS (configs));
+  g_test_minimized_result (chain, "strcmp chain: %.2fms for %u lines",
+                           chain * 1000.0, rounds * G_N_ELEMENTS (configs));
+  g_test_message ("the settings table takes %.0f%% of the time of the "
+                  "strcmp chain", 100.0 * table / MAX (chain, 1e-9));
+
+  g_timer_destroy (timer);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/settings/same", test_settings_same);
+  g_test_add_func ("/settings/timing", test_settings_timing);
+
+  return g_test_run ();
+}